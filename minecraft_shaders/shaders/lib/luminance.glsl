@@ -0,0 +1,13 @@
+// lib/luminance.glsl (same as standalone/shaders/lib/luminance.glsl)
+// Shared by every pass that thresholds or weights by brightness
+#ifndef LUMINANCE_GLSL
+#define LUMINANCE_GLSL
+
+// Rec. 709 luma weights for linear RGB
+const vec3 LUMINANCE_WEIGHTS = vec3(0.2126, 0.7152, 0.0722);
+
+float luminance(vec3 color) {
+    return dot(color, LUMINANCE_WEIGHTS);
+}
+
+#endif
@@ -0,0 +1,40 @@
+# Generates a header with every file under SHADER_DIR as a constexpr
+# EmbeddedShader (see include/shader_sources.h). Run with
+#   cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> -P embed_shaders.cmake
+# Each file becomes EmbeddedShaders::<path with non-alphanumerics as '_'>,
+# e.g. shaders/lib/luminance.glsl -> EmbeddedShaders::lib_luminance_glsl.
+
+file(GLOB_RECURSE SHADER_FILES RELATIVE ${SHADER_DIR} ${SHADER_DIR}/*)
+list(SORT SHADER_FILES)
+
+set(CONTENT "// Generated by cmake/embed_shaders.cmake from ${SHADER_DIR} - do not edit\n")
+string(APPEND CONTENT "#ifndef EMBEDDED_SHADERS_H\n#define EMBEDDED_SHADERS_H\n\n")
+string(APPEND CONTENT "#include \"shader_sources.h\"\n\nnamespace EmbeddedShaders {\n\n")
+
+set(NAMES "")
+foreach(SHADER_FILE ${SHADER_FILES})
+    file(READ ${SHADER_DIR}/${SHADER_FILE} SOURCE)
+    string(FIND "${SOURCE}" ")SHADER\"" CLASH)
+    if(NOT CLASH EQUAL -1)
+        message(FATAL_ERROR "${SHADER_FILE} contains the raw string delimiter )SHADER\"")
+    endif()
+
+    string(MAKE_C_IDENTIFIER ${SHADER_FILE} NAME)
+    list(APPEND NAMES ${NAME})
+    string(APPEND CONTENT "inline constexpr EmbeddedShader ${NAME}{\"${SHADER_FILE}\", R\"SHADER(${SOURCE})SHADER\"};\n\n")
+endforeach()
+
+string(APPEND CONTENT "inline constexpr const EmbeddedShader* all[] = {\n")
+foreach(NAME ${NAMES})
+    string(APPEND CONTENT "    &${NAME},\n")
+endforeach()
+string(APPEND CONTENT "};\n\n}\n\n#endif\n")
+
+# Only touch the header when something changed, so edits elsewhere don't
+# recompile everything that includes it
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} PREVIOUS)
+endif()
+if(NOT "${PREVIOUS}" STREQUAL "${CONTENT}")
+    file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
@@ -0,0 +1,82 @@
+#ifndef BLOOM_GOVERNOR_H
+#define BLOOM_GOVERNOR_H
+
+#include "post_processor.h"
+#include "gpu_timer.h"
+
+// Holds the bloom passes to a GPU time budget by trading quality for speed.
+//
+// Each finished frame's bloom passes (every pass named "bloom ...": source,
+// blur, mip chain and compute) are read from a GpuPassTimer and smoothed.
+// These are the passes the levels scale, and the budget covers them alone;
+// the full resolution composite costs the same at every level, so it isn't
+// counted. A sustained overrun steps down a ladder of quality levels that
+// lower the bloom resolution and shorten the blur; a long stretch well under
+// budget steps back up. Between the two thresholds nothing
+// changes, and a level that is left again soon after being entered makes the
+// next step up wait twice as long, so a borderline scene doesn't flip back
+// and forth. Every change is logged.
+class BloomGovernor {
+public:
+    struct Level {
+        int bloomScale;         // PostProcessor::setBloomScale
+        float radiusScale;      // Fraction of the requested glow radius
+    };
+
+    static const int LEVEL_COUNT = 5;
+    static const Level LEVELS[LEVEL_COUNT];
+
+    BloomGovernor(PostProcessor& post, double budgetMilliseconds = 4.0);
+
+    // Feed the timings of the latest frame; applies any level change to the
+    // post processor (before the next frame's passes are declared)
+    void update(const GpuPassTimer& timer);
+
+    // Radius to pass to addBloomPasses for a requested radius
+    float radius(float requested) const;
+
+    // A disabled governor returns to the full quality level and stays there
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+
+    // GPU time of the scaled bloom passes, composite excluded
+    void setBudget(double milliseconds) { budget = milliseconds; }
+    double getBudget() const { return budget; }
+
+    int getLevel() const { return level; }
+
+    // Smoothed bloom GPU time at the current level
+    double smoothedMilliseconds() const { return smoothed; }
+
+private:
+    // Finished frames ignored after a change, while old queries drain
+    static const int SETTLE_FRAMES = 8;
+    // Consecutive frames over budget before stepping down
+    static const int DOWNGRADE_FRAMES = 15;
+    // Consecutive frames under UPGRADE_HEADROOM x budget before stepping up;
+    // doubled (up to MAX_UPGRADE_FRAMES) each time a step up doesn't hold
+    static const int UPGRADE_FRAMES = 120;
+    static const int MAX_UPGRADE_FRAMES = 1920;
+    // A step up that lasts this many frames held
+    static const int HOLD_FRAMES = 600;
+    static constexpr double UPGRADE_HEADROOM = 0.6;
+    static constexpr double SMOOTHING = 0.1;
+
+    PostProcessor& post;
+    double budget;
+    bool enabled;
+    int level;
+
+    unsigned int lastFrame;     // GpuPassTimer::frameCount() already seen
+    int settle;
+    double smoothed;
+    int overBudget, underBudget;
+    int upgradeFrames;
+    int framesAtLevel;
+    bool upgraded;              // The current level was entered by stepping up
+
+    // Switch levels and log why
+    void changeLevel(int next, const char* reason);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Block types of the voxel world: the host rocks and every ore listed in
+// minecraft_shaders/shaders/block.properties, plus air and glass
+enum class Block : std::uint8_t {
+    Air,
+    Glass,
+    Stone,
+    Deepslate,
+    Netherrack,
+    CoalOre,
+    IronOre,
+    GoldOre,
+    DiamondOre,
+    LapisOre,
+    RedstoneOre,
+    EmeraldOre,
+    CopperOre,
+    DeepslateCoalOre,
+    DeepslateIronOre,
+    DeepslateGoldOre,
+    DeepslateDiamondOre,
+    DeepslateLapisOre,
+    DeepslateRedstoneOre,
+    DeepslateEmeraldOre,
+    DeepslateCopperOre,
+    NetherQuartzOre,
+    NetherGoldOre,
+    AncientDebris,
+    Count
+};
+
+const std::size_t BLOCK_TYPE_COUNT = static_cast<std::size_t>(Block::Count);
+
+struct BlockInfo {
+    const char* name;           // As in block.properties
+    bool opaque;                // Hides the faces of the blocks touching it
+    bool emissive;              // Tagged emissive in block.properties
+};
+
+const BlockInfo& blockInfo(Block block);
+
+// The deepslate variant of an overworld ore (the block itself otherwise)
+Block deepslateVariant(Block ore);
+
+// Columns are 16x16 blocks; sections stack SECTION_SIZE blocks high
+const int CHUNK_WIDTH = 16;
+const int SECTION_SIZE = 16;
+
+// A 16x16x16 cube of blocks, x fastest, then z, then y
+struct ChunkSection {
+    static const int VOLUME = CHUNK_WIDTH * CHUNK_WIDTH * SECTION_SIZE;
+
+    std::array<Block, VOLUME> blocks;
+    int solidBlocks = 0;        // Non-air blocks, so empty sections can be skipped
+
+    ChunkSection() { blocks.fill(Block::Air); }
+
+    static int index(int x, int y, int z) { return (y * CHUNK_WIDTH + z) * CHUNK_WIDTH + x; }
+};
+
+// A 16-wide column of sections, like a Minecraft chunk
+class Chunk {
+public:
+    explicit Chunk(int sectionCount);
+
+    int sectionCount() const { return static_cast<int>(sections.size()); }
+    int height() const { return sectionCount() * SECTION_SIZE; }
+    const ChunkSection& section(int index) const { return sections[index]; }
+
+    // Air outside the chunk
+    Block get(int x, int y, int z) const;
+    void set(int x, int y, int z, Block block);
+
+    // Fill with terrain to mesh: stone over deepslate up to a rolling
+    // surface, ore veins of every overworld ore at roughly their usual depths,
+    // and a few caves to expose them
+    void generateTerrain(unsigned int seed);
+
+    bool contains(int x, int y, int z) const {
+        return x >= 0 && x < CHUNK_WIDTH && z >= 0 && z < CHUNK_WIDTH && y >= 0 && y < height();
+    }
+
+private:
+    std::vector<ChunkSection> sections;
+};
+
+#endif
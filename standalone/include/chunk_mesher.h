@@ -0,0 +1,108 @@
+#ifndef CHUNK_MESHER_H
+#define CHUNK_MESHER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "chunk.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vertex of a chunk mesh, in chunk-local block units. The layout matches the
+// cube's attributes 0-2 plus the texture array layer at attribute 4, read by
+// the glowing shaders built with ORE_FIELD and CHUNK_MESH.
+struct ChunkVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+    std::uint32_t material;     // Texture array layer and OreMaterials index
+};
+
+// Texture array layer of every block type
+typedef std::array<std::uint32_t, BLOCK_TYPE_COUNT> BlockPalette;
+
+// Mesh of a chunk on the CPU: four vertices and six indices per quad
+struct ChunkMeshData {
+    std::vector<ChunkVertex> vertices;
+    std::vector<std::uint32_t> indices;
+
+    std::size_t quadCount() const { return vertices.size() / 4; }
+    std::size_t triangleCount() const { return indices.size() / 3; }
+};
+
+// Neighboring chunks along -X, +X, -Z and +Z, so faces on the chunk's sides
+// can be culled against them. A missing neighbor counts as air.
+struct ChunkNeighbors {
+    const Chunk* negativeX = nullptr;
+    const Chunk* positiveX = nullptr;
+    const Chunk* negativeZ = nullptr;
+    const Chunk* positiveZ = nullptr;
+};
+
+enum class MeshingMode {
+    Faces,      // One quad per visible block face
+    Greedy      // Coplanar visible faces of the same block merged into rectangles
+};
+
+// Turns a chunk's blocks into triangles, emitting only the faces that can be
+// seen: a face is kept when the block beside it is not opaque (air, glass)
+// and is not the same block (no faces inside a pane of glass). Buried stone
+// then costs nothing, which is almost all of it.
+//
+// Greedy meshing goes further and merges the visible faces of each block
+// type in a plane into as few rectangles as it can, so a stone wall is a
+// handful of quads instead of one per block. It works a section at a time
+// on occupancy bitmasks: each 16x16 slice is four 64-bit words, so finding
+// the visible faces of a slice takes a few word operations rather than a
+// lookup per block, and the rectangles are grown along 16-bit rows with bit
+// scans. Merged quads repeat their texture once per block.
+class ChunkMesher {
+public:
+    explicit ChunkMesher(const BlockPalette& palette, MeshingMode mode = MeshingMode::Faces);
+
+    void setMode(MeshingMode mode) { this->mode = mode; }
+    MeshingMode getMode() const { return mode; }
+
+    ChunkMeshData mesh(const Chunk& chunk, const ChunkNeighbors& neighbors = ChunkNeighbors()) const;
+
+    // Quads a mesher drawing every face of every block would emit
+    static std::size_t naiveQuadCount(const Chunk& chunk);
+
+private:
+    BlockPalette palette;
+    MeshingMode mode;
+
+    void meshFaces(const Chunk& chunk, const ChunkNeighbors& neighbors, ChunkMeshData& data) const;
+    void meshGreedy(const Chunk& chunk, const ChunkNeighbors& neighbors, ChunkMeshData& data) const;
+
+    // Neighbor lookup across the chunk's sides
+    static Block blockAt(const Chunk& chunk, const ChunkNeighbors& neighbors, int x, int y, int z);
+};
+
+// A chunk mesh uploaded for drawing
+class ChunkMesh {
+public:
+    ChunkMesh();
+    ~ChunkMesh();
+
+    ChunkMesh(const ChunkMesh&) = delete;
+    ChunkMesh& operator=(const ChunkMesh&) = delete;
+
+    // Replace the mesh; the buffers are reallocated to fit
+    void upload(const ChunkMeshData& data);
+
+    // The caller binds the program and the block textures
+    void draw() const;
+
+    std::size_t triangleCount() const { return indexCount / 3; }
+
+private:
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    std::size_t indexCount;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef COLOR_GRADING_H
+#define COLOR_GRADING_H
+
+#include <GL/glew.h>
+
+#include <vector>
+
+// Tone curve applied after exposure and grading
+enum class ToneMapOperator {
+    Reinhard,   // x / (x + 1) per channel, the original composite curve
+    ACES,       // Narkowicz's fit of the ACES reference rendering transform
+    Filmic,     // Hable's Uncharted 2 curve
+    Linear      // Clamp only
+};
+
+// Everything the grading LUT is baked from. The defaults reproduce the plain
+// Reinhard curve the composite used before grading existed.
+struct GradingParameters {
+    ToneMapOperator toneMap = ToneMapOperator::Reinhard;
+    float exposure = 0.0f;      // In EV (stops)
+    float contrast = 1.0f;      // Slope in log space around middle gray
+    float saturation = 1.0f;    // 0 is grayscale
+    float temperature = 0.0f;   // -1 (cool) to 1 (warm)
+
+    bool operator==(const GradingParameters& other) const;
+    bool operator!=(const GradingParameters& other) const { return !(*this == other); }
+};
+
+// Tone mapping and color grading baked into a 32x32x32 3D texture.
+//
+// The LUT is indexed by the HDR color in log2 space (MIN_EV to MAX_EV stops
+// around 1.0, see shaders/lib/color_grading.glsl), so the composite does one
+// filtered fetch per pixel however long the grading chain gets. The texels
+// are computed on the CPU across all hardware threads and re-uploaded only
+// when the parameters change.
+class ColorGrading {
+public:
+    static const int LUT_SIZE = 32;
+    // Must match lib/color_grading.glsl
+    static constexpr float MIN_EV = -10.0f;
+    static constexpr float MAX_EV = 6.0f;
+
+    ColorGrading();
+    ~ColorGrading();
+
+    ColorGrading(const ColorGrading&) = delete;
+    ColorGrading& operator=(const ColorGrading&) = delete;
+
+    // Takes effect at the next update()
+    void setParameters(const GradingParameters& parameters);
+    const GradingParameters& getParameters() const { return parameters; }
+
+    // Rebake and upload the LUT if the parameters changed since the last
+    // bake; returns true if it did. Call before drawing with the texture.
+    bool update();
+
+    GLuint texture() const { return lut; }
+
+    // CPU time of the last bake
+    double lastBakeMilliseconds() const { return bakeMilliseconds; }
+
+private:
+    GradingParameters parameters;
+    bool dirty;
+    GLuint lut;
+    std::vector<float> texels;  // RGB, red fastest
+    double bakeMilliseconds;
+
+    // Fill the blue slices [first, last) of texels
+    void bakeSlices(int first, int last);
+};
+
+const char* toneMapOperatorName(ToneMapOperator op);
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <GL/glew.h>
+#include "render_target_pool.h"
+#include "gpu_timer.h"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Handle to a texture declared in a FrameGraph
+typedef int FrameResource;
+const FrameResource NO_FRAME_RESOURCE = -1;
+
+// One frame's render passes, declared with the textures they read and write
+// and then compiled before anything is drawn.
+//
+// Compiling culls passes whose outputs nobody reads (writing the backbuffer
+// counts as being read), works out when each texture is first and last used,
+// and lets transient targets with disjoint lifetimes share one pooled
+// texture, so a chain of blur passes only ever holds two of them. Executing
+// acquires each texture from the pool just before its first pass, discards
+// its contents with glInvalidateFramebuffer after its last one (where
+// supported), and only issues framebuffer, viewport, depth and blend changes
+// when a pass needs different ones than the pass before it.
+//
+// Passes run in the order they were added. The graph owns the draw
+// framebuffer binding; a pass may bind GL_READ_FRAMEBUFFER (for a blit) but
+// must leave the draw binding and the state it declared alone.
+class FrameGraph {
+public:
+    // Resolves handles to GL objects while a pass runs
+    class Context {
+    public:
+        GLuint texture(FrameResource resource) const;
+        GLuint framebuffer(FrameResource resource) const;
+
+    private:
+        friend class FrameGraph;
+        explicit Context(const FrameGraph& graph) : graph(graph) {}
+        const FrameGraph& graph;
+    };
+
+    typedef std::function<void(const Context&)> PassFunction;
+
+    // Declares what a pass uses; returned by addPass for chaining
+    class PassBuilder {
+    public:
+        PassBuilder& read(FrameResource resource);
+        // The first resource written picks the framebuffer and viewport
+        PassBuilder& write(FrameResource resource);
+        PassBuilder& depthTest(bool enabled = true);
+        PassBuilder& blend(GLenum source, GLenum destination);
+        // Separate factors for alpha, e.g. to build premultiplied layers
+        PassBuilder& blend(GLenum source, GLenum destination, GLenum alphaSource, GLenum alphaDestination);
+        // Dispatches instead of drawing: no framebuffer or viewport is bound
+        PassBuilder& compute();
+        // Never culled, even if nothing reads what it writes
+        PassBuilder& sideEffect();
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph& graph, int pass) : graph(graph), pass(pass) {}
+        FrameGraph& graph;
+        int pass;
+    };
+
+    explicit FrameGraph(RenderTargetPool& pool);
+    ~FrameGraph();
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    // A transient target, allocated from the pool for the passes using it
+    FrameResource createTarget(const std::string& name, const RenderTargetDesc& desc);
+
+    // A texture that lives outside the graph. framebuffer and attachment say
+    // where passes writing it render to. Discardable contents are only needed
+    // within the frame, so they are invalidated after their last use.
+    FrameResource importTarget(const std::string& name, GLuint texture, const RenderTargetDesc& desc,
+                               GLuint framebuffer, GLenum attachment, bool discardable);
+
+    // The default framebuffer; importing it again returns the same handle
+    FrameResource importBackbuffer(unsigned int width, unsigned int height);
+
+    PassBuilder addPass(const std::string& name, PassFunction run);
+
+    void compile();
+
+    // Run the compiled passes, then advance the pool's frame. With a timer,
+    // every pass that runs is timed under its name.
+    void execute(GpuPassTimer* timer = nullptr);
+
+    // Forget every pass and resource, ready to declare the next frame
+    void reset();
+
+    // Print the compiled passes and the texture each resource landed in
+    void dump(std::ostream& out) const;
+
+    // Rough render target traffic of the compiled frame: each read and each
+    // write of a target counts as touching all of it once. Caches and
+    // framebuffer compression make the real figure lower, but it tracks
+    // format and resolution changes.
+    std::size_t bytesMoved() const;
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported;
+        bool discardable;
+        GLuint texture;         // Imported textures only
+        GLuint framebuffer;     // Imported textures only
+        GLenum attachment;
+        int readers;            // Non-culled passes reading it, while compiling
+        int firstUse;
+        int lastUse;
+        int slot;               // Shared pooled texture of a transient
+    };
+
+    struct PassState {
+        bool depthTest = false;
+        bool blend = false;
+        GLenum blendSource = GL_ONE;
+        GLenum blendDestination = GL_ZERO;
+        GLenum blendAlphaSource = GL_ONE;
+        GLenum blendAlphaDestination = GL_ZERO;
+    };
+
+    struct Pass {
+        std::string name;
+        PassFunction run;
+        std::vector<FrameResource> reads;
+        std::vector<FrameResource> writes;
+        PassState state;
+        bool compute = false;
+        bool sideEffect = false;
+        bool culled = false;
+        int references = 0;
+        std::vector<FrameResource> discards;    // Invalidated after the pass
+    };
+
+    struct Slot {
+        RenderTargetDesc desc;
+        RenderTarget* target;
+        int firstUse;
+        int lastUse;
+    };
+
+    RenderTargetPool& pool;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<Slot> slots;
+    FrameResource backbuffer;
+    bool compiled;
+
+    // GL state left by the previous pass; unknown at the start of a frame
+    bool stateKnown;
+    GLuint boundFramebuffer;
+    unsigned int viewportWidth, viewportHeight;
+    PassState currentState;
+
+    void cull();
+    void assignLifetimes();
+    void assignSlots();
+
+    void applyState(const Pass& pass);
+    void discard(FrameResource resource);
+    void releaseSlots();
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef GAUSSIAN_KERNEL_H
+#define GAUSSIAN_KERNEL_H
+
+#include <vector>
+
+// One-dimensional Gaussian for the separable bloom blur, built at runtime from
+// a radius (and optionally sigma) instead of hardcoded weights.
+//
+// weights() holds the discrete kernel for offsets 0..radius, normalized so
+// the full symmetric kernel sums to 1. bilinearTaps() folds each pair of
+// neighboring texels into one linearly filtered fetch placed between them
+// at the weighted position, which gives the same result with about half
+// the texture reads.
+class GaussianKernel {
+public:
+    struct Tap {
+        float offset;   // In texels from the center
+        float weight;
+    };
+
+    // sigma <= 0 picks radius / 3, so the kernel spans three sigmas
+    explicit GaussianKernel(int radius, float sigma = 0.0f);
+
+    int radius() const { return static_cast<int>(discrete.size()) - 1; }
+    float sigma() const { return deviation; }
+
+    const std::vector<float>& weights() const { return discrete; }
+
+    // Center tap first, then one tap per texel pair on each side
+    std::vector<Tap> bilinearTaps() const;
+
+    // About a phases-th of the bilinear taps, for spreading one blur over
+    // frames. Every phase keeps the center tap and sums to exactly 1, so no
+    // frame is brighter than another, and averaged over all phases the taps
+    // come to exactly bilinearTaps(), which temporal accumulation relies on.
+    // That holds per axis: a 2-D blur has to cycle its horizontal and
+    // vertical phases independently, through every pair, to average to the
+    // full 2-D kernel.
+    std::vector<Tap> interleavedTaps(int phase, int phases) const;
+
+private:
+    std::vector<float> discrete;
+    float deviation;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include <GL/glew.h>
+
+// GL error reporting without glGetError round-trips in the hot path.
+//
+// Errors are pushed by the driver through glDebugMessageCallback (KHR_debug or
+// GL 4.3) and routed to Logger, tagged with the innermost GL_SCOPE on the
+// calling thread. GL_CHECK and GL_SCOPE compile out completely in release
+// builds (NDEBUG); in debug builds on contexts without KHR_debug (macOS 4.1)
+// GL_CHECK falls back to draining glGetError.
+class GLDebug {
+public:
+    // Install the debug callback for the current context. Synchronous mode
+    // makes the driver report errors inside the offending call, so the tag
+    // and a debugger backtrace point at the exact call site; it costs
+    // driver parallelism, so only use it while hunting an error.
+    // Returns false when the context has no debug output.
+    static bool install(bool synchronous);
+
+    static bool callbackInstalled() { return installed; }
+
+    // Per-call check behind GL_CHECK. Does nothing when the callback is
+    // installed, since the driver already reports errors as they happen.
+    static void check(const char* tag);
+
+    // Tags GL calls made while it is alive, and groups them for debuggers
+    // such as RenderDoc via glPushDebugGroup when available
+    class Scope {
+    public:
+        explicit Scope(const char* tag);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* previous;
+    };
+
+private:
+    static bool installed;
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                  GLsizei length, const GLchar* message, const void* userParam);
+};
+
+#define GL_DEBUG_CONCAT_INNER(a, b) a##b
+#define GL_DEBUG_CONCAT(a, b) GL_DEBUG_CONCAT_INNER(a, b)
+
+#ifdef NDEBUG
+#define GL_CHECK(tag) ((void)0)
+#define GL_SCOPE(tag) ((void)0)
+#else
+#define GL_CHECK(tag) GLDebug::check(tag)
+#define GL_SCOPE(tag) GLDebug::Scope GL_DEBUG_CONCAT(glDebugScope, __LINE__)(tag)
+#endif
+
+#endif
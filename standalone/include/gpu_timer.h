@@ -0,0 +1,104 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+// Measures GPU time between begin() and end() with GL_TIME_ELAPSED queries.
+//
+// Results are read a few frames later from a small ring of queries, so
+// timing never stalls the pipeline; a frame whose query slot is still in
+// flight is simply not measured. Only one timer can be active at a time
+// (GL doesn't nest elapsed-time queries).
+class GpuTimer {
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // Most recent finished measurement, in milliseconds
+    double lastMilliseconds() const { return last; }
+
+    // Average over the measurements finished since the last reset
+    double averageMilliseconds() const { return samples > 0 ? total / samples : 0.0; }
+    unsigned int sampleCount() const { return samples; }
+    void reset();
+
+private:
+    static const unsigned int QUERY_COUNT = 4;
+
+    GLuint queries[QUERY_COUNT];
+    bool inFlight[QUERY_COUNT];
+    unsigned int current;
+    bool active;
+
+    double last;
+    double total;
+    unsigned int samples;
+
+    // Collect every finished query without waiting
+    void collect();
+};
+
+// GPU time of every pass in a frame, from a GL_TIMESTAMP query written before
+// each pass and one after the last. Unlike GpuTimer these can be used while
+// an elapsed-time query is active.
+//
+// Like GpuTimer, frames are read back a few frames late from a ring and a
+// frame whose slot is still in flight goes unmeasured.
+class GpuPassTimer {
+public:
+    struct PassTime {
+        std::string name;
+        double milliseconds;
+    };
+
+    GpuPassTimer();
+    ~GpuPassTimer();
+
+    GpuPassTimer(const GpuPassTimer&) = delete;
+    GpuPassTimer& operator=(const GpuPassTimer&) = delete;
+
+    void beginFrame();
+    // Ends the previous pass of the frame, if any, and starts the named one
+    void beginPass(const std::string& name);
+    void endFrame();
+
+    // Passes of the most recent finished frame, in execution order
+    const std::vector<PassTime>& lastFrame() const { return last; }
+
+    // Sum of the last frame's passes whose names start with prefix
+    double milliseconds(const std::string& prefix = "") const;
+
+    // Counts finished frames, so callers can tell when lastFrame() changed
+    unsigned int frameCount() const { return frames; }
+
+private:
+    static const unsigned int FRAME_COUNT = 4;
+
+    struct Frame {
+        std::vector<GLuint> queries;        // Grown as frames get more passes
+        std::vector<std::string> names;
+        unsigned int used = 0;
+        bool inFlight = false;
+    };
+
+    Frame ring[FRAME_COUNT];
+    unsigned int current;
+    bool recording;
+
+    std::vector<PassTime> last;
+    unsigned int frames;
+
+    void mark();
+    void collect();
+};
+
+#endif
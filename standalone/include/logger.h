@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <iomanip>
 #include <ctime>
 
@@ -16,7 +17,8 @@ public:
         DEBUG    // Detailed debugging information - disabled in production
     };
 
-    static LogLevel currentLevel;
+    // Inline so the header can be included from more than one translation unit
+    static inline LogLevel currentLevel = INFO;
 
     // Log a message with a specific level
     static void log(LogLevel level, const std::string& message) {
@@ -88,7 +90,4 @@ public:
     }
 };
 
-// Initialize the static member
-Logger::LogLevel Logger::currentLevel = Logger::INFO;
-
 #endif // LOGGER_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+#ifndef ORE_FIELD_H
+#define ORE_FIELD_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "uniform_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One block of an ore field. Blocks sit on the grid unrotated, so an offset
+// is their whole transform; the model matrix in FrameConstants places the
+// field as a whole.
+struct OreInstance {
+    glm::vec3 position;
+    std::uint32_t oreType;      // Texture array layer and OreMaterials index
+};
+
+static_assert(sizeof(OreInstance) == 16, "OreInstance is uploaded as is");
+
+// Material of one ore type in the field
+struct OreMaterial {
+    glm::vec3 color;            // Glow color
+    float glowStrength;
+    GLuint diffuseMap;          // 2D textures, copied into the field's arrays
+    GLuint emissiveMap;
+};
+
+// Draws any number of blocks of every ore type with one instanced draw.
+//
+// The cube is an indexed 24-vertex mesh; per-instance offsets and ore types
+// come from a second vertex buffer with a divisor of 1. The ore textures are
+// copied into a pair of 2D texture arrays with a layer per ore type, and the
+// materials into the OreMaterials uniform block, so nothing changes between
+// ore types and the whole field is a single glDrawElementsInstanced.
+//
+// Draw it with the glowing shaders built with ORE_FIELD defined; the vertex
+// layout matches the single cube's plus attributes 3 (offset) and 4 (type).
+// The materials don't have to be ores: any block type can have a layer.
+class OreFieldRenderer {
+public:
+    // Layer size of the texture arrays (ore textures are 16x16)
+    static const int TEXTURE_SIZE = 16;
+
+    explicit OreFieldRenderer(const std::vector<OreMaterial>& materials);
+    ~OreFieldRenderer();
+
+    OreFieldRenderer(const OreFieldRenderer&) = delete;
+    OreFieldRenderer& operator=(const OreFieldRenderer&) = delete;
+
+    // Replace the blocks; the instance buffer is reallocated to fit
+    void setInstances(const std::vector<OreInstance>& instances);
+    std::size_t instanceCount() const { return instances; }
+    int oreTypeCount() const { return oreTypes; }
+
+    // Bind the texture arrays to units 0 and 1 and draw every block. The
+    // caller binds the program and anything else it samples.
+    void draw() const;
+
+    // Bind just the texture arrays, for other geometry using the same
+    // materials (see ChunkMesh)
+    void bindMaterials() const;
+
+    // count blocks of random ore types packed into a cube, spacing apart and
+    // centered on the origin
+    static std::vector<OreInstance> generateField(std::size_t count, int oreTypes, float spacing,
+                                                  unsigned int seed = 1);
+    // Blocks along each edge of the cube generateField packs count into
+    static int fieldSide(std::size_t count);
+
+private:
+    GLuint vao;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint instanceBuffer;
+    GLuint diffuseArray;
+    GLuint emissiveArray;
+    UniformBlock<OreMaterialConstants> materialBlock;
+    std::size_t instances;
+    int oreTypes;
+
+    void initMesh();
+    // Copy each material's 2D texture into a layer of a new texture array
+    GLuint buildTextureArray(const std::vector<OreMaterial>& materials, GLuint OreMaterial::*map);
+};
+
+#endif
@@ -3,56 +3,360 @@
 
 #include <GL/glew.h>
 #include "shader.h"
+#include "program_pipeline.h"
+#include "gpu_timer.h"
+#include "shader_watcher.h"
+#include "uniform_buffer.h"
+#include "render_target_pool.h"
+#include "frame_graph.h"
+#include "color_grading.h"
+
+#include <cstddef>
+
+// How the bright parts are blurred. PingPong runs reduced-resolution separable
+// Gaussian passes, so its cost grows with the blur radius. MipChain halves the
+// resolution down a chain of mips and tent-filters back up; the whole chain
+// touches about a third of a full frame, whatever the glow radius. Compute
+// runs the same Gaussian as PingPong as tiled compute dispatches that read
+// each texel into shared memory once (GL 4.3 only). Temporal keeps last
+// frame's bloom and blends in a PingPong blur that uses only half of the
+// kernel's taps each frame, alternating halves; in a slowly changing scene
+// the history averages them back into the full kernel.
+enum class BloomMode {
+    PingPong,
+    MipChain,
+    Compute,
+    Temporal
+};
+
+// Where the bright parts come from. BrightBuffer uses the scene's MRT output
+// (attachment 1, already thresholded by glowing.frag) and only blits it down
+// to half resolution. Extract thresholds the scene color with
+// bloom_extract.frag instead, for scene shaders that don't write a bright
+// output; it costs an extra pass over the full-resolution scene.
+enum class BloomSource {
+    BrightBuffer,
+    Extract
+};
+
+// Internal formats of the post chain's color targets. Nothing downstream
+// reads alpha, so the default packed R11F_G11F_B10F keeps the HDR range of
+// GL_RGBA16F at 4 bytes per pixel instead of 8, halving both the memory and
+// the bandwidth of every pass that touches them.
+struct PostTargetFormats {
+    GLenum scene = GL_R11F_G11F_B10F;   // Scene color (MRT attachment 0)
+    GLenum bright = GL_R11F_G11F_B10F;  // Bright buffer (MRT attachment 1)
+    GLenum bloom = GL_R11F_G11F_B10F;   // Every bloom target
+};
+
+// Auto-exposure: the scene's average luminance is metered on the GPU every
+// frame and the exposure eases toward mapping it to key. The adapted state
+// stays in a 1x1 texture that the composite and the bloom thresholds read,
+// so nothing is read back to the CPU.
+struct ExposureSettings {
+    bool enabled = false;
+    float key = 0.18f;              // Middle gray
+    float minLogLuminance = -10.0f; // Metered range, in log2 luminance
+    float maxLogLuminance = 6.0f;
+    float adaptationRate = 1.5f;    // Per second; higher adapts faster
+};
 
 class PostProcessor {
 public:
-    // Constructor and destructor
-    PostProcessor(unsigned int width, unsigned int height);
+    static const int MAX_BLOOM_MIPS = 6;   // 1/2 down to 1/64 resolution
+    static const int TEMPORAL_PHASES = 2;  // Kernel tap subsets Temporal cycles through
+    
+    // The scene MRT as imported into a frame graph
+    struct SceneTargets {
+        FrameResource color;
+        FrameResource bright;
+        FrameResource depth;
+    };
+    
+    // Constructor and destructor. With ShaderBuildMode::Async all post programs
+    // are submitted at once and bloom is skipped until they are ready.
+    PostProcessor(unsigned int width, unsigned int height, ShaderBuildMode mode = ShaderBuildMode::Blocking);
     ~PostProcessor();
     
-    // Resize framebuffers when window size changes
+    // Resize the render targets when the window size changes; only targets
+    // whose size actually changed are reallocated
     void resize(unsigned int width, unsigned int height);
     
-    // Start rendering to framebuffer
+    // Start rendering to framebuffer (outside a frame graph)
     void beginRender();
     
     // End rendering to framebuffer
     void endRender();
     
-    // Apply bloom effect
-    void applyBloom(float threshold, float intensity, int blur_passes);
+    // True once every post-processing program has finished building
+    bool isReady();
+    
+    // Hot reload the post-processing programs when their sources change
+    void watchShaders(ShaderWatcher& watcher);
+    
+    // Dirty tracking. Call before declaring a frame with a hash of everything
+    // the scene pass depends on (transforms, material, lighting). While it and
+    // the bloom settings hold, addBloomPasses recomposites last frame's bloom
+    // instead of running the extract and blur passes again. Returns whether
+    // the scene has to be drawn: false only for a static scene whose hash
+    // and targets are unchanged, which can leave its scene pass out.
+    // The bloom thresholds, the scene's included, follow the exposure, so
+    // while auto-exposure is still adapting no frame counts as unchanged.
+    bool beginFrame(std::size_t sceneHash);
+    
+    // A static scene keeps its targets across frames instead of discarding
+    // them, so they can be reused while the scene hash holds
+    void setStaticScene(bool enabled);
+    bool isStaticScene() const { return staticScene; }
+    
+    // Forget the cached scene and bloom, for changes the hash can't see
+    // (a reloaded shader, for one)
+    void invalidateCache();
+    
+    // True if the last addBloomPasses reused the cached bloom
+    bool isBloomCached() const { return bloomCached; }
+    
+    // Import the scene targets into graph. A scene pass writing them renders
+    // into the MRT framebuffer; their contents are discarded after the frame
+    // unless the scene is static.
+    SceneTargets importSceneTargets(FrameGraph& graph);
+    
+    // A full-resolution RGBA8 layer for the HUD, drawn over the graded image
+    // by the composite so the frame makes one full-screen write to the
+    // backbuffer. Passes drawing into it should clear it to transparent and
+    // blend with (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE,
+    // GL_ONE_MINUS_SRC_ALPHA), leaving premultiplied alpha.
+    FrameResource createHudLayer(FrameGraph& graph);
+    
+    // Add the bloom passes and the composite onto the backbuffer. radius is
+    // the glow reach in full-resolution pixels: the Gaussian modes build a
+    // kernel of that radius (splitting it over several passes beyond
+    // MAX_BLUR_RADIUS), MipChain picks a chain depth. threshold only applies
+    // to BloomSource::Extract; the bright buffer was thresholded when the
+    // scene was drawn. hud, if given, is a layer from createHudLayer. Until the
+    // programs are ready the scene is blitted as is, without the HUD.
+    void addBloomPasses(FrameGraph& graph, const SceneTargets& scene, float threshold, float intensity, float radius,
+                        FrameResource hud = NO_FRAME_RESOURCE);
+    
+    // Apply bloom effect after beginRender/endRender, as a frame graph of its own
+    void applyBloom(float threshold, float intensity, float radius);
+    
+    // Select the blur implementation; all supported modes stay available for
+    // A/B timing. The default is Compute where supported, else PingPong.
+    // Returns false (and keeps the current mode) if the mode isn't supported.
+    bool setBloomMode(BloomMode mode);
+    bool supportsBloomMode(BloomMode mode) const;
+    BloomMode getBloomMode() const { return bloomMode; }
+    
+    // Temporal bloom: weight of the new frame in the history (1 replaces it).
+    // The history resets itself when the bloom targets, source, threshold or
+    // radius change noticeably; call resetBloomHistory for scene changes it
+    // can't see, such as switching to a different model.
+    void setTemporalWeight(float weight);
+    float getTemporalWeight() const { return temporalWeight; }
+    void resetBloomHistory() { historyValid = false; }
+    
+    // Defaults to BrightBuffer
+    void setBloomSource(BloomSource source) { bloomSource = source; }
+    BloomSource getBloomSource() const { return bloomSource; }
+    
+    // Reallocates the scene targets if their formats changed
+    void setTargetFormats(const PostTargetFormats& formats);
+    const PostTargetFormats& getTargetFormats() const { return targetFormats; }
+    
+    // Bloom targets start at 1/2^scale of the scene size: 1 (the default) is
+    // half resolution, 2 quarter resolution
+    void setBloomScale(int scale);
+    int getBloomScale() const { return bloomScale; }
+    
+    // Deepest mip chain the radius may select (1 to MAX_BLOOM_MIPS)
+    void setBloomMipCount(int count);
+    int getBloomMipCount() const { return bloomMipCount; }
+    
+    // With GL 4.3 metering builds a 256-bin luminance histogram with compute
+    // shaders; on 4.1 it averages log luminance down a mipmap chain
+    void setExposure(const ExposureSettings& settings);
+    const ExposureSettings& getExposure() const { return exposure; }
+    
+    // Whether the adapted exposure has stopped moving (always while it's off)
+    bool isExposureSettled() const { return exposureSettled; }
+    
+    // 1x1 RG32F: r = adapted luminance, g = exposure multiplier. A neutral
+    // texture (multiplier 1) while auto-exposure is off. Scene shaders that
+    // threshold by brightness can sample it through lib/exposure.glsl.
+    GLuint getExposureTexture() const;
+    
+    // Tone mapping and grading applied by the composite; set its parameters
+    // at any time and the LUT is rebaked before the next composite
+    ColorGrading& getGrading() { return *grading; }
+    
+    // GPU time of the threshold and blur passes (not the final composite)
+    GpuTimer& getBloomTimer() { return *bloomTimer; }
     
     // Render a quad with the final result to the screen
     void renderToScreen();
     
     // Getter methods
-    unsigned int getSceneTexture() const { return colorBuffers[0]; }
-    unsigned int getBrightTexture() const { return colorBuffers[1]; }
+    unsigned int getSceneTexture() const { return sceneTarget->texture; }
+    unsigned int getBrightTexture() const { return brightTarget->texture; }
+    
+    // Textures backing the post chain; frame graphs draw their transient
+    // targets from the same pool
+    RenderTargetPool& getRenderTargets() { return *targets; }
+    const RenderTargetPool& getRenderTargets() const { return *targets; }
     
 private:
     // Screen dimensions
     unsigned int width, height;
     
-    // Shader programs
+    // Separable stages, combined in one pipeline
+    Shader *quadStage;          // Shared vertex stage (not owned)
     Shader *extractShader;
-    Shader *blurShader;
+    Shader *blurShaders[2];     // Horizontal, vertical (not owned, see Shader::variant)
     Shader *finalShader;
+    Shader *downsampleShader;
+    Shader *upsampleShader;
+    Shader *computeBlurShaders[3];  // Threshold + horizontal, horizontal, vertical; null without GL 4.3
+    ProgramPipeline *pipeline;
+    
+    // Pre-resolved uniform handles for the per-frame passes
+    UniformHandle<float> extractThreshold;
+    UniformHandle<float> finalBloomIntensity;
+    UniformHandle<int> finalBloomBlur;
+    UniformHandle<float> upsampleRadius;
+    UniformHandle<float> computeThreshold;
+    
+    BloomMode bloomMode;
+    BloomSource bloomSource;
+    PostTargetFormats targetFormats;
+    int bloomScale;
+    int bloomMipCount;
+    GpuTimer *bloomTimer;
+    ColorGrading *grading;
+    
+    // Gaussian shared by the blur passes, re-uploaded only when its radius
+    // or tap subset changes
+    UniformBlock<BlurKernelConstants> *kernelBlock;
+    int kernelRadius;
+    int kernelPhases[2];        // Horizontal, vertical
+    
+    // Temporal bloom history, kept across frames at bloom resolution, and
+    // what it was accumulated with
+    RenderTarget *historyTarget;
+    bool historyValid;
+    float temporalWeight;
+    float historyThreshold;
+    float historyRadius;
+    BloomSource historySource;
+    unsigned long temporalFrame;
+    
+    // Dirty tracking state. The bloom cache holds the blurred bloom once its
+    // inputs repeat (Temporal uses its history instead).
+    bool staticScene;
+    bool sceneValid;            // Scene targets hold the scene of sceneHash
+    bool sceneHashSet;          // beginFrame was called for this frame
+    std::size_t sceneHash;
+    std::size_t bloomHash;
+    int bloomStaticFrames;      // Consecutive frames with the same bloomHash
+    bool bloomCacheValid;
+    bool bloomCached;
+    RenderTarget *bloomCache;
+    
+    // Auto-exposure. The state ping-pongs between two 1x1 textures: each
+    // frame reads the last one and writes the other.
+    ExposureSettings exposure;
+    Shader *histogramShader;        // Compute path; null without GL 4.3
+    Shader *exposureComputeShader;
+    Shader *luminanceLogShader;     // Fragment path
+    Shader *exposureAdaptShader;
+    UniformHandle<float> histogramMinLog;
+    UniformHandle<float> histogramInverseRange;
+    UniformHandle<float> computeAdaptMinLog;
+    UniformHandle<float> computeAdaptRange;
+    UniformHandle<float> computeAdaptation;
+    UniformHandle<float> computeAdaptKey;
+    UniformHandle<float> logMinLog;
+    UniformHandle<float> logMaxLog;
+    UniformHandle<float> adaptation;
+    UniformHandle<float> adaptKey;
+    UniformHandle<float> adaptMeanLevel;
+    unsigned int histogramBuffer;
+    unsigned int meteringTexture;   // Log luminance with mipmaps (fragment path)
+    unsigned int meteringFBO;
+    unsigned int exposureTextures[2];
+    unsigned int exposureFBOs[2];
+    unsigned int neutralExposureTexture;
+    int exposureCurrent;            // Written by the latest frame
+    double lastExposureTime;        // Seconds, for the adaptation step
     
-    // Framebuffers and textures
-    unsigned int hdrFBO;
-    unsigned int colorBuffers[2];
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongBuffers[2];
+    // Whether the exposure has settled, worked out without reading it back:
+    // each frame closes 1 - exp(-rate * dt) of the gap to the target, and
+    // after a disturbance the gap is at most the metered range, so enough
+    // adaptation time since then bounds it by EXPOSURE_TOLERANCE. Until
+    // then the caches aren't reused.
+    static constexpr float EXPOSURE_TOLERANCE = 0.01f;
+    double exposureAdaptedTime;     // Seconds adapted since the last disturbance
+    bool exposureSettled;
+    
+    // Every texture comes from the pool. The scene targets are held for the
+    // life of the window size; the bloom targets are frame graph transients.
+    RenderTargetPool *targets;
+    unsigned int hdrFBO;                        // Scene MRT, attachments from the pool
+    RenderTarget *sceneTarget;
+    RenderTarget *brightTarget;
+    RenderTarget *depthTarget;
     
     // Quad VAO for rendering post-process effects
     unsigned int quadVAO;
     
-    // Initialize framebuffers
-    void initFramebuffers();
+    // 1x1 transparent texture the composite samples when there is no HUD
+    unsigned int emptyHudTexture;
+    
+    // (Re)acquire the scene targets for the current size and attach them
+    void attachSceneTargets();
+    
+    // Hash of the scene hash and every setting the blurred bloom depends on
+    std::size_t hashBloomInputs(float threshold, float radius) const;
+    
+    // Description of a transient bloom target at a mip level's size
+    RenderTargetDesc bloomDesc(int level) const;
+    
+    // Reduced-resolution bloom source from the bright buffer or the extract
+    // pass; starts the bloom timer
+    FrameResource addSourcePass(FrameGraph& graph, const SceneTargets& scene, float threshold);
+    
+    // Blur implementations; each returns the resource holding the blurred bloom
+    FrameResource addPingPongPasses(FrameGraph& graph, const SceneTargets& scene, float threshold, float radius);
+    FrameResource addMipChainPasses(FrameGraph& graph, const SceneTargets& scene, float threshold, float radius);
+    FrameResource addComputePasses(FrameGraph& graph, const SceneTargets& scene, float threshold, float radius);
+    FrameResource addTemporalPasses(FrameGraph& graph, const SceneTargets& scene, float threshold, float radius);
     
-    // Initialize quad geometry
+    // Split a blur radius into horizontal + vertical pass pairs no wider than
+    // MAX_BLUR_RADIUS each, upload the per-pass kernel and return the pair
+    // count. Phases of 0 to TEMPORAL_PHASES - 1 upload that subset of the
+    // taps for the horizontal and the vertical passes.
+    int prepareKernel(float radius, int horizontalPhase = -1, int verticalPhase = -1);
+    
+    // Size of a level of the bloom mip chain; level 0 is the bloom source
+    unsigned int mipWidth(int level) const;
+    unsigned int mipHeight(int level) const;
+    
+    // Initialize quad geometry and the empty HUD texture
     void initQuad();
     
+    // Create the exposure textures, buffers and metering target
+    void initExposure();
+    
+    // Something changed what the exposure adapts to
+    void disturbExposure();
+    
+    // Meter the scene and adapt the exposure state; returns the state the
+    // rest of the frame reads
+    FrameResource addExposurePasses(FrameGraph& graph, const SceneTargets& scene);
+    
+    // Resolve uniform handles and bind the fixed sampler units
+    void initUniforms();
+    
     // Render quad to screen
     void renderQuad();
 };
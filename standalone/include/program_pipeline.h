@@ -0,0 +1,30 @@
+#ifndef PROGRAM_PIPELINE_H
+#define PROGRAM_PIPELINE_H
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+// A program pipeline object (ARB_separate_shader_objects, core in GL 4.1)
+// that combines separable single-stage Shaders. The post-processing passes
+// share one vertex stage and only swap the fragment stage between passes.
+class ProgramPipeline {
+public:
+    ProgramPipeline();
+    ~ProgramPipeline();
+
+    ProgramPipeline(const ProgramPipeline&) = delete;
+    ProgramPipeline& operator=(const ProgramPipeline&) = delete;
+
+    // Bind the pipeline with these stages. Stages are only re-attached when
+    // the program behind them changed (a different pass, or a hot reload).
+    void use(const Shader& vertex, const Shader& fragment);
+
+    unsigned int ID;
+
+private:
+    unsigned int vertexProgram;
+    unsigned int fragmentProgram;
+};
+
+#endif
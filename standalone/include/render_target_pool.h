@@ -0,0 +1,82 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// What a render target is allocated as; targets with equal descriptions are
+// interchangeable
+struct RenderTargetDesc {
+    unsigned int width;
+    unsigned int height;
+    GLenum format;      // Sized internal format, e.g. GL_RGBA16F or GL_DEPTH_COMPONENT24
+    int samples;        // 1 for a plain 2D texture
+
+    bool operator<(const RenderTargetDesc& other) const;
+    bool operator==(const RenderTargetDesc& other) const;
+};
+
+// A pooled texture. Color targets come with a framebuffer that has the
+// texture as its only attachment, so a pass can render into (or blit from)
+// the target directly; depth targets have fbo == 0 and are meant to be
+// attached to a caller's framebuffer.
+struct RenderTarget {
+    RenderTargetDesc desc;
+    GLuint texture;
+    GLuint fbo;
+    unsigned long lastUsed;     // Frame the target was last released in
+};
+
+// Recycles render target textures across passes and frames.
+//
+// acquire() hands out a free target matching the description, allocating one
+// only when none is free; release() returns it for the next pass or frame to
+// reuse. Free targets that go unused for a while (after a resize, or a bloom
+// mode that needs fewer of them) are deleted by endFrame(). The pool owns
+// every target it created and deletes them all with it, attachments
+// included.
+class RenderTargetPool {
+public:
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    RenderTarget* acquire(const RenderTargetDesc& desc);
+    void release(RenderTarget* target);
+
+    // Release target if it no longer matches desc and acquire one that does.
+    // Returns the target unchanged when it already matches, so a resize only
+    // reallocates the targets whose size actually changed.
+    RenderTarget* reacquire(RenderTarget* target, const RenderTargetDesc& desc);
+
+    // Advance the frame counter and delete free targets idle for too long
+    void endFrame();
+
+    std::size_t targetCount() const { return owned.size(); }
+    std::size_t freeCount() const { return available.size(); }
+    std::size_t allocatedBytes() const { return bytes; }
+
+    // GPU memory a target with this description takes
+    static std::size_t sizeOf(const RenderTargetDesc& desc);
+
+private:
+    // Targets in use are released and reacquired every frame, so anything
+    // idle for a few frames belongs to an old size or an unused pass. Keeping
+    // this short bounds the memory held while a window is being dragged.
+    static const unsigned long MAX_IDLE_FRAMES = 4;
+
+    std::multimap<RenderTargetDesc, RenderTarget*> available;
+    std::vector<RenderTarget*> owned;
+    unsigned long frame = 0;
+    std::size_t bytes = 0;
+
+    static RenderTarget* create(const RenderTargetDesc& desc);
+    static void destroy(RenderTarget* target);
+};
+
+#endif
@@ -5,35 +5,259 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <filesystem>
 
+#include "shader_preprocessor.h"
+#include "shader_sources.h"
+#include "uniform_table.h"
+
+// Pre-resolved handle to a uniform, obtained once with Shader::uniform<T>().
+// The handle indexes a slot owned by the shader rather than holding the
+// location itself, so it stays valid if the program is ever relinked.
+template <typename T>
+struct UniformHandle {
+    int slot = -1;
+    bool valid() const { return slot >= 0; }
+};
+
+// Blocking builds are ready when the constructor returns. Async builds only
+// submit the work; poll isReady() and render something else until it's true.
+enum class ShaderBuildMode {
+    Blocking,
+    Async
+};
+
 class Shader {
 public:
     // Program ID
     unsigned int ID;
+
+    // Build from sources compiled into the binary (see shader_sources.h); no
+    // file I/O unless ShaderSources has an override directory
+    Shader(const EmbeddedShader& vertex, const EmbeddedShader& fragment, const ShaderDefines& defines = ShaderDefines(),
+           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    Shader(GLenum stageType, const EmbeddedShader& stage, const ShaderDefines& defines = ShaderDefines(),
+           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    
+    // Constructor reads and builds the shader from files on disk
+    Shader(const char* vertexPath, const char* fragmentPath, ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    // Same, with #defines injected after #version to specialize the program
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines,
+           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    // Single-stage program: a separable stage to combine with others in a
+    // ProgramPipeline, or a complete compute program (GL 4.3)
+    Shader(GLenum stageType, const char* path, const ShaderDefines& defines = ShaderDefines(),
+           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    ~Shader();
+    
+    // Programs own a GL object, so they can't be copied
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    
+    // Build a program from in-memory sources instead of files
+    static Shader* fromSource(const char* vertexSource, const char* fragmentSource,
+                              ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    
+    // Shared program for a set of source files and defines, built on first
+    // request and owned by the variant cache until releaseVariants()
+    static Shader* variant(const EmbeddedShader& vertex, const EmbeddedShader& fragment, const ShaderDefines& defines,
+                           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    static Shader* variant(GLenum stageType, const EmbeddedShader& stage, const ShaderDefines& defines = ShaderDefines(),
+                           ShaderBuildMode mode = ShaderBuildMode::Blocking);
+    // Delete every cached variant (call before the GL context goes away)
+    static void releaseVariants();
     
-    // Constructor reads and builds the shader
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Non-blocking readiness check. Finishes an async build (error checks,
+    // reflection, caching) on the first call after the driver is done.
+    bool isReady();
+    bool hasFailed() const { return state == BuildState::Failed; }
     
-    // Use/activate the shader
+    // Run per-program setup (e.g. sampler units) now if linked and again after
+    // every future link. Uniform setters don't need the program bound.
+    void onLinked(std::function<void(Shader&)> setup);
+    
+    // Enable GL_KHR_parallel_shader_compile if the driver has it. Returns false
+    // when async builds need ShaderCompileWorker instead.
+    static bool initParallelCompile();
+    
+    // Hot reload: re-read the source files and submit an asynchronous rebuild.
+    // The current program keeps rendering until commitReload() swaps the new
+    // one in; a build that fails to compile or link is dropped and logged.
+    // Returns false for programs built from memory or with nothing submitted.
+    bool reload();
+    // Swap in a finished reload, if any. Call between frames; never blocks.
+    bool commitReload();
+    // Whether this program was built from, or includes, a file with this name
+    // (no directory)
+    bool usesSourceFile(const std::string& fileName) const;
+
+    // Use/activate the shader (separable stages are bound via ProgramPipeline)
     void use();
     
-    // Utility uniform functions
+    bool isSeparable() const { return separable; }
+
+    // Resolve a uniform once, up front. T must match the GLSL type
+    // (bool, int/sampler, float, glm::vec3, glm::vec4, glm::mat4).
+    template <typename T>
+    UniformHandle<T> uniform(const std::string &name);
+
+    // Set uniforms through pre-resolved handles (no driver lookups). All
+    // setters use glProgramUniform, so they work whether or not the program
+    // is current, including for separable stages in a pipeline.
+    void set(UniformHandle<bool> handle, bool value) const;
+    void set(UniformHandle<int> handle, int value) const;
+    void set(UniformHandle<float> handle, float value) const;
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const;
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const;
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4 &value) const;
+
+    // Utility uniform functions (resolved through the reflection table)
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
     void setVec3(const std::string &name, const glm::vec3 &value) const;
     void setMat4(const std::string &name, const glm::mat4 &value) const;
 
+    // Check whether the linked program has an active uniform with this name
+    bool hasUniform(const std::string &name) const { return uniforms.find(name) != nullptr; }
+
+    // Driver-side uniform lookups (glGetUniformLocation) since the last reset.
+    // Call takeDriverLookups() once per frame; steady-state frames should report 0.
+    static unsigned int takeDriverLookups();
+    
+    // Cache linked program binaries in this directory (empty disables the cache).
+    // Binaries are keyed by the final sources, GL_RENDERER and GL_VERSION.
+    static void setProgramCacheDirectory(const std::string& directory);
+    
+    // Cumulative program build statistics, for cold vs. warm start comparison
+    struct BuildStats {
+        unsigned int programs = 0;
+        unsigned int cacheHits = 0;
+        double milliseconds = 0.0;
+    };
+    static BuildStats buildStats();
+
 private:
+    // Where a stage was loaded from, for reloading
+    struct SourceFile {
+        GLenum type;
+        std::string path;       // Embedded name, or a path on disk
+        bool embedded;
+    };
+    
+    // One stage of a program, ready to hand to glShaderSource
+    struct StageSource {
+        GLenum type;
+        std::string label;      // Used in compile error messages
+        std::string source;
+    };
+    
+    // Objects of a build that has been submitted but not checked yet
+    struct PendingBuild {
+        std::vector<std::string> labels;
+        std::vector<unsigned int> shaders;
+        unsigned int program = 0;
+        uint64_t key = 0;
+        std::chrono::steady_clock::time_point start;
+        std::shared_ptr<std::atomic<bool>> workerDone;  // Only for worker-thread builds
+    };
+    
+    enum class BuildState { Compiling, Ready, Failed };
+    
+    BuildState state = BuildState::Compiling;
+    std::shared_ptr<PendingBuild> pending;
+    std::vector<std::function<void(Shader&)>> linkCallbacks;
+    
+    std::vector<SourceFile> sourceFiles;        // Empty for fromSource() programs
+    ShaderDefines defines;
+    std::vector<std::string> includedFiles;     // Every file the last load read
+    bool separable = false;
+    std::shared_ptr<PendingBuild> reloadPending;
+    bool reloadQueued = false;                  // Files changed again mid-reload
+    
+    Shader() : ID(0) {}
+    
+    // Read and preprocess every source file; throws if one can't be read
+    std::vector<StageSource> loadStages();
+    
+    // Load the program from the binary cache, or submit its compile (and
+    // finish it right away unless building asynchronously)
+    void build(const std::vector<StageSource>& stages, ShaderBuildMode mode);
+    std::shared_ptr<PendingBuild> submitBuild(const std::vector<StageSource>& stages, uint64_t key,
+                                              std::chrono::steady_clock::time_point start, bool async) const;
+    static void submitStages(const std::vector<StageSource>& stages, bool retrievable, bool separable,
+                             PendingBuild& target);
+    // Non-blocking check whether the driver (or worker) is done with a build
+    static bool buildComplete(const PendingBuild& build);
+    // Check a finished build for errors and return its program. Throws, and
+    // deletes the build's objects, on compile or link failure.
+    unsigned int checkBuild(const PendingBuild& build);
+    // Wait for a build that is no longer wanted and delete its objects
+    static void discardBuild(const PendingBuild& build);
+    // Check the initial build for errors and adopt its program
+    void finishBuild();
+    void completeBuild(bool cacheHit, std::chrono::steady_clock::time_point start);
+    // Reflect the program in ID and run the link callbacks
+    void adoptProgram();
+    // Replace the current program with a freshly linked one
+    void swapProgram(unsigned int program);
+    
+    static bool parallelCompile;
+    static std::map<std::string, Shader*> variants;
+    static std::string variantKey(const std::string& sources, const ShaderDefines& defines);
+    
+    static std::string programCacheDirectory;
+    static BuildStats stats;
+    
+    uint64_t programKey(const std::vector<StageSource>& stages) const;
+    // Returns the loaded program, or 0 on a miss
+    static unsigned int loadCachedBinary(uint64_t key);
+    static void storeCachedBinary(unsigned int program, uint64_t key);
+    
+    // Reflection data for the linked program
+    UniformTable uniforms;
+
+    // Locations behind the handles returned by uniform<T>()
+    std::vector<std::string> slotNames;
+    std::vector<GLint> slotLocations;
+
+    static unsigned int driverLookups;
+
+    // Build the uniform table and re-resolve all handle slots
+    void reflectUniforms();
+    // Allocate (or reuse) a handle slot for a uniform, checking its type
+    int resolveSlot(const std::string &name, GLenum expectedType);
+    // Look up a location through the reflection table, warning if missing
+    GLint locationOf(const std::string &name) const;
     // Utility function for checking shader compilation/linking errors
-    void checkCompileErrors(unsigned int shader, std::string type);
-    // Utility function for checking OpenGL errors
-    void checkGLError(const char* operation) const; // Added 'const' here
+    void checkCompileErrors(unsigned int shader, const std::string& type);
 };
 
-#endif
\ No newline at end of file
+// GL type each C++ handle type is expected to bind to
+template <typename T> struct UniformGLType;
+template <> struct UniformGLType<bool> { static constexpr GLenum value = GL_BOOL; };
+template <> struct UniformGLType<int> { static constexpr GLenum value = GL_INT; };
+template <> struct UniformGLType<float> { static constexpr GLenum value = GL_FLOAT; };
+template <> struct UniformGLType<glm::vec3> { static constexpr GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformGLType<glm::vec4> { static constexpr GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformGLType<glm::mat4> { static constexpr GLenum value = GL_FLOAT_MAT4; };
+
+template <typename T>
+UniformHandle<T> Shader::uniform(const std::string &name) {
+    UniformHandle<T> handle;
+    handle.slot = resolveSlot(name, UniformGLType<T>::value);
+    return handle;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SHADER_COMPILE_WORKER_H
+#define SHADER_COMPILE_WORKER_H
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Background thread with its own GL context that shares objects with the main
+// window. Used to compile shaders off the render thread on drivers without
+// GL_KHR_parallel_shader_compile.
+class ShaderCompileWorker {
+public:
+    // Create a hidden context sharing with mainWindow and start the thread.
+    // Must be called from the main thread (GLFW window creation rule).
+    static bool start(GLFWwindow* mainWindow);
+
+    // Finish outstanding tasks and tear the context down
+    static void stop();
+
+    static bool running();
+
+    // Run a task on the worker context. The returned flag flips once the task
+    // has finished and its GL work is complete and visible to other contexts.
+    static std::shared_ptr<std::atomic<bool>> submit(std::function<void()> task);
+
+private:
+    struct Task {
+        std::function<void()> work;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    static GLFWwindow* context;
+    static std::thread thread;
+    static std::mutex mutex;
+    static std::condition_variable wake;
+    static std::deque<Task> tasks;
+    static bool stopping;
+
+    static void run();
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Compile-time switches for a shader variant, injected as "#define NAME VALUE"
+// right after the #version line. A std::map keeps them in a canonical order,
+// so the same set always produces the same source (and cache keys).
+using ShaderDefines = std::map<std::string, std::string>;
+
+// Expands #include "file" directives and injects defines before a source is
+// handed to the driver.
+//
+// Relative includes resolve against the including file's directory; paths
+// starting with '/' resolve against the root file's directory, which matches
+// the OptiFine shader pack convention (#include "/lib/luminance.glsl").
+// Every file is included at most once per stage. #line directives keep
+// compiler messages pointing at the original line, using the file's index
+// in Result::files as the GLSL source string number.
+class ShaderPreprocessor {
+public:
+    // Returns the contents of a file by path; throws if it doesn't exist
+    using Loader = std::function<std::string(const std::string& path)>;
+
+    struct Result {
+        std::string source;
+        std::vector<std::string> files;     // Root file first, then includes
+    };
+
+    // Files (the root and every include) are fetched through load, so the
+    // same expansion works on disk files and embedded sources. Throws
+    // std::runtime_error if a file can't be read.
+    static Result process(const std::string& path, const ShaderDefines& defines, const Loader& load);
+
+    // Inject defines into an in-memory source (no include support)
+    static std::string injectDefines(const std::string& source, const ShaderDefines& defines);
+
+private:
+    static void expand(const std::string& path, const std::string& root, const Loader& load, Result& result);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SHADER_SOURCES_H
+#define SHADER_SOURCES_H
+
+#include <string>
+#include <string_view>
+
+// A file from standalone/shaders/, compiled into the binary by
+// cmake/embed_shaders.cmake. The generated embedded_shaders.h declares one
+// per file as EmbeddedShaders::<name>, e.g. EmbeddedShaders::quad_vert.
+struct EmbeddedShader {
+    std::string_view name;      // Path relative to the shader directory
+    std::string_view source;
+};
+
+// Where embedded shader sources come from at runtime.
+//
+// By default every source is served straight from the binary, so building a
+// program does no file I/O and doesn't depend on the working directory. For
+// development, an override directory makes files found there win over the
+// embedded copies, which is what hot reload edits.
+class ShaderSources {
+public:
+    // Empty (the default) serves embedded sources only
+    static void setOverrideDirectory(const std::string& directory);
+    static const std::string& overrideDirectory() { return overrides; }
+
+    // Embedded file by name relative to the shader directory, or nullptr
+    static const EmbeddedShader* findEmbedded(std::string_view name);
+
+    // Source for a name relative to the shader directory: the override file
+    // if there is one, otherwise the embedded copy. Throws if neither exists.
+    static std::string load(const std::string& name);
+
+    // Read a file from disk in a single copy. Throws if it can't be read.
+    static std::string readFile(const std::string& path);
+
+private:
+    static std::string overrides;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <string>
+#include <vector>
+
+#include "shader.h"
+
+// Watches the shader directory and hot reloads programs whose sources change.
+//
+// On Linux this uses a non-blocking inotify descriptor, so update() costs one
+// read() syscall per frame when nothing changed. Rebuilds are submitted
+// asynchronously and the old program keeps rendering until the new one has
+// linked; a broken edit is logged and the old program stays in place.
+// On other platforms the watcher does nothing.
+class ShaderWatcher {
+public:
+    explicit ShaderWatcher(const std::string& directory = "shaders");
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Reload this shader when one of its source files changes. The shader
+    // must outlive the watcher or be removed with unwatch().
+    void watch(Shader* shader);
+    void unwatch(Shader* shader);
+
+    // Poll for file changes, start reloads and swap in finished ones.
+    // Call once per frame, between frames. Returns true if a reloaded
+    // program was swapped in.
+    bool update();
+
+    bool active() const { return fd >= 0; }
+
+private:
+    std::string directory;
+    int fd;
+    std::vector<Shader*> shaders;
+
+    // Names of files written since the last poll, without duplicates
+    std::vector<std::string> readChangedFiles();
+};
+
+#endif
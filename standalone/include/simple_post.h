@@ -4,6 +4,7 @@
 
 #include <GL/glew.h>
 #include "shader.h"
+#include "program_pipeline.h"
 
 class SimplePostProcessor {
 public:
@@ -18,8 +19,11 @@ private:
     unsigned int width, height;
     unsigned int framebuffer;
     unsigned int textureColorBuffer;
+    unsigned int depthStencilBuffer;
     unsigned int quadVAO;
+    Shader* quadStage;      // Shared via Shader::variant, not owned
     Shader* screenShader;
+    ProgramPipeline* pipeline;
     
     void initFramebuffer();
     void initQuad();
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <iostream>
+#include "shader.h"
 
 // A simplified text renderer that uses colored quads instead of actual text
 // This provides a more reliable fallback for debugging
@@ -31,11 +32,15 @@ public:
             "    FragColor = color;\n"
             "}\n";
 
-        // Compile shader program
-        shader = createShaderFromSource(vertexShaderSource, fragmentShaderSource);
+        // Compile shader program (through Shader so it shares the binary cache)
+        shader = Shader::fromSource(vertexShaderSource, fragmentShaderSource);
+        colorUniform = shader->uniform<glm::vec4>("color");
         
-        // Set up orthographic projection
+        // The projection only depends on the window size, so set it once
         projection = glm::ortho(0.0f, (float)width, 0.0f, (float)height);
+        shader->use();
+        shader->set(shader->uniform<glm::mat4>("projection"), projection);
+        glUseProgram(0);
         
         // Create a simple quad VAO for drawing indicators
         setupQuadVAO();
@@ -45,7 +50,7 @@ public:
         glDeleteVertexArrays(1, &quadVAO);
         glDeleteBuffers(1, &quadVBO);
         glDeleteBuffers(1, &quadEBO);
-        glDeleteProgram(shader);
+        delete shader;
     }
     
     // Render a color indicator for a value (like a bar or dot)
@@ -69,12 +74,10 @@ public:
     // Render a simple indicator using a colored quad
     void renderQuad(float x, float y, float width, float height, glm::vec4 color) {
         // Use our shader
-        glUseProgram(shader);
+        shader->use();
         
         // Set uniform values
-        glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, 
-                           glm::value_ptr(projection));
-        glUniform4fv(glGetUniformLocation(shader, "color"), 1, glm::value_ptr(color));
+        shader->set(colorUniform, color);
         
         // Update the quad vertices for this specific position and size
         float vertices[] = {
@@ -144,10 +147,8 @@ public:
                 x + size/2,  y + size       // Top middle
             };
             
-            glUseProgram(shader);
-            glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, 
-                              glm::value_ptr(projection));
-            glUniform4fv(glGetUniformLocation(shader, "color"), 1, glm::value_ptr(color));
+            shader->use();
+            shader->set(colorUniform, color);
             
             glBindVertexArray(quadVAO);
             glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
@@ -163,10 +164,8 @@ public:
                 x + size/2,  y              // Bottom middle
             };
             
-            glUseProgram(shader);
-            glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, 
-                              glm::value_ptr(projection));
-            glUniform4fv(glGetUniformLocation(shader, "color"), 1, glm::value_ptr(color));
+            shader->use();
+            shader->set(colorUniform, color);
             
             glBindVertexArray(quadVAO);
             glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
@@ -182,7 +181,8 @@ public:
 
 private:
     unsigned int width, height;
-    unsigned int shader;
+    Shader* shader;
+    UniformHandle<glm::vec4> colorUniform;
     unsigned int quadVAO, quadVBO, quadEBO;
     glm::mat4 projection;
     
@@ -216,56 +216,6 @@ private:
         
         glBindVertexArray(0);
     }
-    
-    // Helper function to create a shader program from source strings
-    unsigned int createShaderFromSource(const char* vertexSource, const char* fragmentSource) {
-        unsigned int vertexShader, fragmentShader, shaderProgram;
-        
-        // Vertex shader
-        vertexShader = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertexShader, 1, &vertexSource, NULL);
-        glCompileShader(vertexShader);
-        
-        // Check for compile errors
-        int success;
-        char infoLog[512];
-        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-        }
-        
-        // Fragment shader
-        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-        glCompileShader(fragmentShader);
-        
-        // Check for compile errors
-        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-        if (!success) {
-            glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-        }
-        
-        // Shader program
-        shaderProgram = glCreateProgram();
-        glAttachShader(shaderProgram, vertexShader);
-        glAttachShader(shaderProgram, fragmentShader);
-        glLinkProgram(shaderProgram);
-        
-        // Check for linking errors
-        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-        if (!success) {
-            glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        }
-        
-        // Delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        
-        return shaderProgram;
-    }
 };
 
 #endif // SIMPLE_TEXT_RENDERER_H
\ No newline at end of file
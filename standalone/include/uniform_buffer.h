@@ -0,0 +1,123 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+
+// Binding points for the shared uniform blocks. Shader binds any active block
+// with a matching name when it links, so every program reads the same upload.
+enum UniformBlockBinding : GLuint {
+    FRAME_BLOCK_BINDING = 0,
+    MATERIAL_BLOCK_BINDING = 1,
+    BLUR_KERNEL_BLOCK_BINDING = 2,
+    ORE_MATERIAL_BLOCK_BINDING = 3
+};
+
+// C++ mirror of the std140 FrameConstants block (see shaders/glowing.vert)
+struct alignas(16) FrameConstants {
+    glm::mat4 model;                // Scene transform
+    glm::mat4 view;
+    glm::mat4 projection;
+    alignas(16) glm::vec3 viewPos;  // vec3 aligns to 16 in std140...
+    float ambientLight;             // ...and a float may pack into its last 4 bytes
+    float bloomThreshold;
+};
+
+static_assert(offsetof(FrameConstants, model) == 0, "FrameConstants.model must match std140");
+static_assert(offsetof(FrameConstants, view) == 64, "FrameConstants.view must match std140");
+static_assert(offsetof(FrameConstants, projection) == 128, "FrameConstants.projection must match std140");
+static_assert(offsetof(FrameConstants, viewPos) == 192, "FrameConstants.viewPos must match std140");
+static_assert(offsetof(FrameConstants, ambientLight) == 204, "FrameConstants.ambientLight must match std140");
+static_assert(offsetof(FrameConstants, bloomThreshold) == 208, "FrameConstants.bloomThreshold must match std140");
+
+// C++ mirror of the std140 MaterialConstants block (see shaders/glowing.frag)
+struct alignas(16) MaterialConstants {
+    alignas(16) glm::vec3 oreColor;
+    float glowStrength;
+};
+
+static_assert(offsetof(MaterialConstants, oreColor) == 0, "MaterialConstants.oreColor must match std140");
+static_assert(offsetof(MaterialConstants, glowStrength) == 12, "MaterialConstants.glowStrength must match std140");
+static_assert(sizeof(MaterialConstants) == 16, "MaterialConstants must match std140");
+
+// Limit of the OreMaterials block (see shaders/glowing.frag, ORE_FIELD)
+const int MAX_ORE_TYPES = 16;
+
+// C++ mirror of the std140 OreMaterials block: every ore type's material, so
+// one instanced draw can shade all of them
+struct alignas(16) OreMaterialConstants {
+    glm::vec4 ores[MAX_ORE_TYPES];  // rgb = glow color, a = glow strength
+};
+
+static_assert(sizeof(OreMaterialConstants) == 16 * MAX_ORE_TYPES, "OreMaterialConstants must match std140");
+
+// Limits of the BlurKernel block (see shaders/lib/blur_kernel.glsl)
+const int MAX_BLUR_RADIUS = 32;
+const int MAX_BLUR_TAPS = MAX_BLUR_RADIUS / 2 + 1;
+
+// C++ mirror of the std140 BlurKernel block, filled from a GaussianKernel
+struct alignas(16) BlurKernelConstants {
+    int radius;                                     // Discrete weights in use
+    int tapCount;                                   // Bilinear taps in use, horizontal pass
+    int verticalTapCount;                           // The vertical pass's
+    alignas(16) glm::vec4 taps[MAX_BLUR_TAPS];      // x = offset in texels, y = weight
+    glm::vec4 verticalTaps[MAX_BLUR_TAPS];          // Same as taps except in Temporal bloom
+    glm::vec4 weights[(MAX_BLUR_RADIUS + 4) / 4];   // Discrete weights, four per vec4
+};
+
+static_assert(offsetof(BlurKernelConstants, radius) == 0, "BlurKernelConstants.radius must match std140");
+static_assert(offsetof(BlurKernelConstants, tapCount) == 4, "BlurKernelConstants.tapCount must match std140");
+static_assert(offsetof(BlurKernelConstants, verticalTapCount) == 8,
+              "BlurKernelConstants.verticalTapCount must match std140");
+static_assert(offsetof(BlurKernelConstants, taps) == 16, "BlurKernelConstants.taps must match std140");
+static_assert(offsetof(BlurKernelConstants, verticalTaps) == 16 + 16 * MAX_BLUR_TAPS,
+              "BlurKernelConstants.verticalTaps must match std140");
+static_assert(offsetof(BlurKernelConstants, weights) == 16 + 32 * MAX_BLUR_TAPS,
+              "BlurKernelConstants.weights must match std140");
+
+// Look up the binding point for a named uniform block. Returns false for
+// blocks that programs bind themselves.
+bool uniformBlockBinding(const std::string& blockName, GLuint& binding);
+
+// One uniform buffer split into a ring of per-frame slots. Each update writes
+// the next slot with an unsynchronized map, guarded by a fence placed when the
+// slot was last used, so the CPU never waits on draws still reading it.
+class UniformRingBuffer {
+public:
+    UniformRingBuffer(GLuint binding, std::size_t size, unsigned int frames = 3);
+    ~UniformRingBuffer();
+
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    // Copy data into the next slot and bind it to the block's binding point
+    void update(const void* data);
+
+private:
+    static const unsigned int MAX_FRAMES = 4;
+
+    GLuint buffer;
+    GLuint binding;
+    std::size_t size;
+    GLsizeiptr stride;
+    unsigned int frames;
+    unsigned int current;
+    GLsync fences[MAX_FRAMES];
+};
+
+// Typed wrapper so a block can only be updated with its mirror struct
+template <typename T>
+class UniformBlock {
+public:
+    explicit UniformBlock(GLuint binding, unsigned int frames = 3) : ring(binding, sizeof(T), frames) {}
+
+    void update(const T& data) { ring.update(&data); }
+
+private:
+    UniformRingBuffer ring;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything we need to know about an active uniform once the program is linked
+struct UniformInfo {
+    GLint location;
+    GLenum type;
+    GLint size;     // Array length, 1 for non-arrays
+};
+
+// Compact open-addressing hash table of a program's active uniforms.
+// Built once from glGetActiveUniform after linking so that name lookups
+// never have to go through the driver again.
+class UniformTable {
+public:
+    // Enumerate the active uniforms of a linked program. Returns the number
+    // of driver lookups this took, so callers can account for them.
+    unsigned int build(GLuint program);
+
+    // Find a uniform by name (array uniforms are stored without "[0]")
+    const UniformInfo* find(const std::string& name) const;
+
+    std::size_t size() const { return count; }
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t hash;          // 0 marks an empty slot
+        uint32_t nameOffset;    // Offset into the name pool
+        UniformInfo info;
+    };
+
+    std::vector<Entry> entries; // Power-of-two capacity, linear probing
+    std::string names;          // NUL-separated name pool
+    std::size_t count = 0;
+
+    static uint32_t hashName(const char* name, std::size_t length);
+    void insert(const std::string& name, const UniformInfo& info);
+};
+
+#endif
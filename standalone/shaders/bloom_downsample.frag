@@ -0,0 +1,23 @@
+#version 410 core
+
+// One step down the bloom mip chain. Dual-filter (Kawase) downsample: a
+// bilinear tap at the center plus four at the destination texel's corners,
+// each averaging 2x2 source texels, so a 4x4 footprint costs five fetches.
+
+out vec4 FragColor;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
+
+uniform sampler2D source;   // The next larger mip
+
+void main() {
+    // One source texel is half a destination texel
+    vec2 texel = 1.0 / vec2(textureSize(source, 0));
+    
+    vec3 sum = texture(source, TexCoords).rgb * 4.0;
+    sum += texture(source, TexCoords + vec2(-texel.x, -texel.y)).rgb;
+    sum += texture(source, TexCoords + vec2( texel.x, -texel.y)).rgb;
+    sum += texture(source, TexCoords + vec2(-texel.x,  texel.y)).rgb;
+    sum += texture(source, TexCoords + vec2( texel.x,  texel.y)).rgb;
+    
+    FragColor = vec4(sum / 8.0, 1.0);
+}
@@ -1,7 +1,10 @@
 #version 410 core
 
+#include "lib/luminance.glsl"
+#include "lib/exposure.glsl"
+
 out vec4 FragColor;
-in vec2 TexCoords;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
 
 uniform sampler2D scene;
 uniform float threshold;
@@ -10,8 +13,9 @@ void main() {
     // Sample the scene texture
     vec3 color = texture(scene, TexCoords).rgb;
     
-    // Calculate brightness of the pixel (using luminance formula)
-    float brightness = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    // Calculate brightness of the pixel (using luminance formula), as
+    // displayed after exposure
+    float brightness = luminance(color) * sceneExposure();
     
     // If the pixel is bright enough, keep its color; otherwise set it to black
     if (brightness > threshold) {
@@ -1,10 +1,14 @@
 #version 410 core
 
+#include "lib/color_grading.glsl"
+#include "lib/exposure.glsl"
+
 out vec4 FragColor;
-in vec2 TexCoords;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
 
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
+uniform sampler2D hudLayer;     // Premultiplied alpha, transparent when there's no HUD
 uniform float bloomIntensity;
 
 void main() {
@@ -15,9 +19,13 @@ void main() {
     // Add bloom to the original scene, scaled by bloom intensity
     originalColor += bloomColor * bloomIntensity;
     
-    // Apply simple tone mapping to prevent oversaturation
-    // This uses a basic Reinhard operator
-    originalColor = originalColor / (originalColor + vec3(1.0));
+    // Auto-exposure, adapted on the GPU (1 when it's off)
+    originalColor *= sceneExposure();
+    
+    // Tone mapping and grading in one LUT fetch (see ColorGrading)
+    originalColor = applyGrading(originalColor);
     
-    FragColor = vec4(originalColor, 1.0);
+    // The HUD goes on top of the graded image, in the same write
+    vec4 hud = texture(hudLayer, TexCoords);
+    FragColor = vec4(originalColor * (1.0 - hud.a) + hud.rgb, 1.0);
 }
\ No newline at end of file
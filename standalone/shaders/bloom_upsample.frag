@@ -0,0 +1,28 @@
+#version 410 core
+
+// One step up the bloom mip chain: a 3x3 tent filter over the smaller mip,
+// added (by additive blending) onto the next larger one. Each level widens
+// the glow, so the radius comes from the chain depth rather than tap count.
+
+out vec4 FragColor;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
+
+uniform sampler2D source;       // The next smaller mip
+uniform float filterRadius;     // Tent spacing in source texels
+
+void main() {
+    vec2 d = filterRadius / vec2(textureSize(source, 0));
+    
+    // Weights 1 2 1 / 2 4 2 / 1 2 1, normalized by 16
+    vec3 sum = texture(source, TexCoords).rgb * 4.0;
+    sum += (texture(source, TexCoords + vec2(-d.x, 0.0)).rgb +
+            texture(source, TexCoords + vec2( d.x, 0.0)).rgb +
+            texture(source, TexCoords + vec2(0.0, -d.y)).rgb +
+            texture(source, TexCoords + vec2(0.0,  d.y)).rgb) * 2.0;
+    sum += texture(source, TexCoords + vec2(-d.x, -d.y)).rgb +
+           texture(source, TexCoords + vec2( d.x, -d.y)).rgb +
+           texture(source, TexCoords + vec2(-d.x,  d.y)).rgb +
+           texture(source, TexCoords + vec2( d.x,  d.y)).rgb;
+    
+    FragColor = vec4(sum / 16.0, 1.0);
+}
@@ -1,34 +1,35 @@
 #version 410 core
 
+// Compiled twice: with HORIZONTAL defined for the horizontal pass and without
+// it for the vertical one, so the direction is a constant instead of a branch
+
+#include "lib/blur_kernel.glsl"
+
 out vec4 FragColor;
-in vec2 TexCoords;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
 
 uniform sampler2D image;
-uniform bool horizontal;
 
-// Gaussian weights for a 9-tap filter
-const float weights[5] = float[5](0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+#ifdef HORIZONTAL
+const vec2 direction = vec2(1.0, 0.0);
+#define TAP_COUNT blurTapCount
+#define TAPS blurTaps
+#else
+const vec2 direction = vec2(0.0, 1.0);
+#define TAP_COUNT blurVerticalTapCount
+#define TAPS blurVerticalTaps
+#endif
 
 void main() {
-    // Get the size of a single texel (1 pixel in texture space)
-    vec2 texOffset = 1.0 / textureSize(image, 0);
-    vec3 result = texture(image, TexCoords).rgb * weights[0]; // Central pixel weight
+    // Get the size of a single texel (1 pixel in texture space), along the blur direction
+    vec2 texOffset = direction / vec2(textureSize(image, 0));
+    vec3 result = texture(image, TexCoords).rgb * TAPS[0].y; // Central pixel weight
     
-    // Apply blur in either horizontal or vertical direction
-    if (horizontal) {
-        // Horizontal blur pass
-        for (int i = 1; i < 5; ++i) {
-            // Add weighted samples from neighboring pixels
-            result += texture(image, TexCoords + vec2(texOffset.x * i, 0.0)).rgb * weights[i];
-            result += texture(image, TexCoords - vec2(texOffset.x * i, 0.0)).rgb * weights[i];
-        }
-    } else {
-        // Vertical blur pass
-        for (int i = 1; i < 5; ++i) {
-            result += texture(image, TexCoords + vec2(0.0, texOffset.y * i)).rgb * weights[i];
-            result += texture(image, TexCoords - vec2(0.0, texOffset.y * i)).rgb * weights[i];
-        }
+    // Each tap sits between two texels, so linear filtering fetches both at once
+    for (int i = 1; i < TAP_COUNT; ++i) {
+        vec2 offset = texOffset * TAPS[i].x;
+        result += (texture(image, TexCoords + offset).rgb + texture(image, TexCoords - offset).rgb) * TAPS[i].y;
     }
     
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,23 @@
+#version 410 core
+
+// Eases the exposure state toward the metered luminance (the fragment
+// counterpart of exposure_adapt.comp); drawn into a 1x1 target
+
+out vec4 FragColor;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
+
+uniform sampler2D previousState;    // Last frame's exposure state
+uniform sampler2D logLuminance;     // Metering target with its mipmaps
+uniform float meanLevel;            // Its last (1x1) mip level
+uniform float adaptation;           // 1 - exp(-rate * dt): how far to move this frame
+uniform float key;                  // Luminance the average is exposed to
+
+void main() {
+    // The last mip level is the mean of the log luminance
+    float meanLog = textureLod(logLuminance, vec2(0.5), meanLevel).r;
+    float target = exp2(meanLog);
+    
+    float previous = texelFetch(previousState, ivec2(0), 0).r;
+    float adapted = previous + (target - previous) * adaptation;
+    FragColor = vec4(adapted, key / adapted, 0.0, 1.0);
+}
@@ -1,5 +1,8 @@
 #version 410 core
 
+#include "lib/luminance.glsl"
+#include "lib/exposure.glsl"
+
 // Two output colors: one for the rendered scene and one for bright parts
 layout (location = 0) out vec4 FragColor;      // Main color output
 layout (location = 1) out vec4 BrightColor;    // Bright parts for bloom
@@ -8,23 +11,55 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
+#ifdef ORE_FIELD
+// Instanced blocks of every ore type: textures are arrays with a layer per
+// ore type, and the material comes from the table below
+flat in uint OreType;
+uniform sampler2DArray diffuseTexture;
+uniform sampler2DArray emissiveTexture;
+#else
 // Textures
 uniform sampler2D diffuseTexture;   // Base texture (ore texture)
 uniform sampler2D emissiveTexture;   // Emissive mask (where the ore glows)
+#endif
+
+// Per-frame lighting parameters (shared with glowing.vert)
+layout (std140) uniform FrameConstants {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;                   // Camera position
+    float ambientLight;             // Ambient light level (0.0 to 1.0)
+    float bloomThreshold;           // Pixels brighter than this go into the bright buffer
+};
 
-// Lighting parameters
-uniform vec3 viewPos;               // Camera position
-uniform float ambientLight;         // Ambient light level (0.0 to 1.0)
-uniform vec3 oreColor;              // Color of the ore's glow
-uniform float glowStrength;         // Base strength of the glow
+#ifdef ORE_FIELD
+#define MAX_ORE_TYPES 16
 
-// Bloom threshold - any pixels brighter than this go into the bright buffer
-uniform float bloomThreshold;
+// Every ore type's material (mirrored by OreMaterialConstants)
+layout (std140) uniform OreMaterials {
+    vec4 oreMaterials[MAX_ORE_TYPES];   // rgb = glow color, a = glow strength
+};
+#else
+// Per-material parameters
+layout (std140) uniform MaterialConstants {
+    vec3 oreColor;                  // Color of the ore's glow
+    float glowStrength;             // Base strength of the glow
+};
+#endif
 
 void main() {
+#ifdef ORE_FIELD
+    vec3 oreColor = oreMaterials[OreType].rgb;
+    float glowStrength = oreMaterials[OreType].a;
+    vec3 texCoords = vec3(TexCoords, float(OreType));
+#else
+    vec2 texCoords = TexCoords;
+#endif
+    
     // Sample textures
-    vec4 diffuseColor = texture(diffuseTexture, TexCoords);
-    vec4 emissiveMask = texture(emissiveTexture, TexCoords);
+    vec4 diffuseColor = texture(diffuseTexture, texCoords);
+    vec4 emissiveMask = texture(emissiveTexture, texCoords);
     
     // Calculate basic lighting
     vec3 norm = normalize(Normal);
@@ -47,8 +82,8 @@ void main() {
     FragColor = vec4(result, diffuseColor.a);
     
     // Check if the pixel is bright enough for bloom
-    // We'll use the emissive parts only
-    float brightness = dot(oreColor * dynamicGlow, vec3(0.2126, 0.7152, 0.0722));
+    // We'll use the emissive parts only, as bright as they'll be displayed
+    float brightness = luminance(oreColor * dynamicGlow) * sceneExposure();
     if (brightness > bloomThreshold) {
         BrightColor = vec4(oreColor * dynamicGlow, 1.0);
     } else {
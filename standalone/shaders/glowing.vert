@@ -4,25 +4,57 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+#ifdef ORE_FIELD
+// Per-instance block data (see OreInstance in ore_field.h). Chunk meshes
+// (CHUNK_MESH) are already in place and carry the layer per vertex.
+#ifndef CHUNK_MESH
+layout (location = 3) in vec3 aOffset;
+#endif
+layout (location = 4) in uint aOreType;
+flat out uint OreType;
+#endif
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame camera and lighting state, shared by every program (std140,
+// mirrored by FrameConstants in uniform_buffer.h)
+layout (std140) uniform FrameConstants {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float ambientLight;
+    float bloomThreshold;
+};
 
 void main() {
-    // Calculate fragment position in world space (for lighting)
-    FragPos = vec3(model * vec4(aPos, 1.0));
+#ifdef ORE_FIELD
+    // Blocks are only translated within the field, and the field is rotated
+    // and uniformly scaled, so the model matrix itself transforms normals
+    // (no per-vertex inverse with a million instances)
+#ifdef CHUNK_MESH
+    vec3 position = aPos;
+#else
+    vec3 position = aPos + aOffset;
+#endif
+    Normal = mat3(model) * aNormal;
+    OreType = aOreType;
+#else
+    vec3 position = aPos;
     
     // Transform normals to world space
     // The normal matrix is the transpose of the inverse of the model matrix
     Normal = mat3(transpose(inverse(model))) * aNormal;
+#endif
+    
+    // Calculate fragment position in world space (for lighting)
+    FragPos = vec3(model * vec4(position, 1.0));
     
     // Pass texture coordinates to fragment shader
     TexCoords = aTexCoords;
     
     // Calculate final position
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
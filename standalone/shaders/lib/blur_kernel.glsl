@@ -0,0 +1,24 @@
+// shaders/lib/blur_kernel.glsl
+// Runtime Gaussian shared by the bloom blur passes (see GaussianKernel and
+// BlurKernelConstants, which mirrors this block)
+#ifndef BLUR_KERNEL_GLSL
+#define BLUR_KERNEL_GLSL
+
+#define MAX_BLUR_RADIUS 32
+#define MAX_BLUR_TAPS 17
+
+layout (std140) uniform BlurKernel {
+    int blurRadius;                                 // Discrete weights in use
+    int blurTapCount;                               // Bilinear taps in use, horizontal pass
+    int blurVerticalTapCount;                       // The vertical pass's
+    vec4 blurTaps[MAX_BLUR_TAPS];                   // x = offset in texels, y = weight
+    vec4 blurVerticalTaps[MAX_BLUR_TAPS];           // Same as blurTaps except in Temporal bloom
+    vec4 blurWeights[(MAX_BLUR_RADIUS + 4) / 4];    // Discrete weights, four per vec4
+};
+
+// Discrete weight for a texel this far from the center
+float blurWeight(int offset) {
+    return blurWeights[offset / 4][offset % 4];
+}
+
+#endif
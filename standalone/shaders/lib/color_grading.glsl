@@ -0,0 +1,24 @@
+// shaders/lib/color_grading.glsl
+// Tone mapping and grading through the LUT baked by ColorGrading
+#ifndef COLOR_GRADING_GLSL
+#define COLOR_GRADING_GLSL
+
+// Must match ColorGrading::LUT_SIZE, MIN_EV and MAX_EV
+#define GRADING_LUT_SIZE 32.0
+#define GRADING_MIN_EV -10.0
+#define GRADING_MAX_EV 6.0
+
+uniform sampler3D gradingLut;
+
+// HDR scene-linear color in, display color out
+vec3 applyGrading(vec3 color) {
+    // Log2 shaper: the LUT spans MIN_EV to MAX_EV stops, anything darker is black
+    vec3 coords = (log2(max(color, vec3(1e-6))) - GRADING_MIN_EV) / (GRADING_MAX_EV - GRADING_MIN_EV);
+    coords = clamp(coords, 0.0, 1.0);
+    
+    // Land on texel centers so the ends of the range aren't half-filtered
+    coords = coords * ((GRADING_LUT_SIZE - 1.0) / GRADING_LUT_SIZE) + 0.5 / GRADING_LUT_SIZE;
+    return texture(gradingLut, coords).rgb;
+}
+
+#endif
@@ -0,0 +1,13 @@
+// shaders/lib/exposure.glsl
+// Adapted exposure written by the auto-exposure passes (see PostProcessor)
+#ifndef EXPOSURE_GLSL
+#define EXPOSURE_GLSL
+
+// 1x1: r = adapted scene luminance, g = exposure multiplier (1 when off)
+uniform sampler2D exposureState;
+
+float sceneExposure() {
+    return texelFetch(exposureState, ivec2(0), 0).g;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#version 410 core
+
+// Auto-exposure metering without compute shaders: log2 luminance of the scene
+// into a small power-of-two target, whose mipmap chain then averages it down
+// to one texel (the scene's geometric mean luminance)
+
+#include "lib/luminance.glsl"
+
+out vec4 FragColor;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
+
+uniform sampler2D scene;
+uniform float minLogLuminance;
+uniform float maxLogLuminance;
+
+void main() {
+    float value = luminance(texture(scene, TexCoords).rgb);
+    FragColor = vec4(clamp(log2(max(value, 1e-6)), minLogLuminance, maxLogLuminance), 0.0, 0.0, 1.0);
+}
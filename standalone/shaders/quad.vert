@@ -3,9 +3,15 @@
 layout (location = 0) in vec2 aPos;
 layout (location = 1) in vec2 aTexCoords;
 
-out vec2 TexCoords;
+// Built as a separable stage shared by every post-processing pass. Separable
+// programs must redeclare the built-ins they write, and outputs are matched
+// to the fragment stages by location
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+layout (location = 0) out vec2 TexCoords;
 
 void main() {
     TexCoords = aTexCoords;
     gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
-}
\ No newline at end of file
+}
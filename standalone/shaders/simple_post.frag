@@ -1,7 +1,7 @@
 // shaders/simple_post.frag
 #version 410 core
 out vec4 FragColor;
-in vec2 TexCoords;
+layout (location = 0) in vec2 TexCoords;   // From quad.vert
 
 uniform sampler2D screenTexture;
 
@@ -0,0 +1,92 @@
+#include "bloom_governor.h"
+#include <iomanip>
+#include <iostream>
+
+// Each step roughly halves the cost of the one before: shorter kernels
+// first, then a smaller bloom target (a quarter of the texels)
+const BloomGovernor::Level BloomGovernor::LEVELS[BloomGovernor::LEVEL_COUNT] = {
+    {1, 1.0f},      // Half resolution, full radius
+    {1, 0.7f},
+    {2, 1.0f},      // Quarter resolution
+    {2, 0.7f},
+    {3, 0.7f}       // Eighth resolution
+};
+
+BloomGovernor::BloomGovernor(PostProcessor& post, double budgetMilliseconds)
+    : post(post), budget(budgetMilliseconds), enabled(true), level(0), lastFrame(0),
+      settle(SETTLE_FRAMES), smoothed(0.0), overBudget(0), underBudget(0),
+      upgradeFrames(UPGRADE_FRAMES), framesAtLevel(0), upgraded(false) {
+    post.setBloomScale(LEVELS[level].bloomScale);
+}
+
+void BloomGovernor::update(const GpuPassTimer& timer) {
+    if (!enabled || timer.frameCount() == lastFrame) {
+        return;
+    }
+    lastFrame = timer.frameCount();
+    
+    // Frames without bloom passes (not running yet, or reusing the cached
+    // bloom) say nothing about its cost; keep the estimate as it was
+    double milliseconds = timer.milliseconds("bloom");
+    if (milliseconds <= 0.0) {
+        return;
+    }
+    // Frames still timing the previous level seed the estimate afresh
+    if (settle > 0) {
+        settle--;
+        smoothed = milliseconds;
+        return;
+    }
+    smoothed += SMOOTHING * (milliseconds - smoothed);
+    framesAtLevel++;
+    
+    // A step up that survived long enough resets the backoff
+    if (upgraded && framesAtLevel == HOLD_FRAMES) {
+        upgradeFrames = UPGRADE_FRAMES;
+        upgraded = false;
+    }
+    
+    overBudget = smoothed > budget ? overBudget + 1 : 0;
+    underBudget = smoothed < budget * UPGRADE_HEADROOM ? underBudget + 1 : 0;
+    
+    if (overBudget >= DOWNGRADE_FRAMES && level + 1 < LEVEL_COUNT) {
+        // Stepping straight back down: wait longer before trying again
+        if (upgraded) {
+            upgradeFrames = upgradeFrames * 2 > MAX_UPGRADE_FRAMES ? MAX_UPGRADE_FRAMES : upgradeFrames * 2;
+        }
+        changeLevel(level + 1, "over budget");
+    } else if (underBudget >= upgradeFrames && level > 0) {
+        changeLevel(level - 1, "under budget");
+        upgraded = true;
+    }
+}
+
+float BloomGovernor::radius(float requested) const {
+    return requested * LEVELS[level].radiusScale;
+}
+
+void BloomGovernor::setEnabled(bool enable) {
+    if (enable == enabled) {
+        return;
+    }
+    if (!enable && level != 0) {
+        changeLevel(0, "governor disabled");
+    }
+    enabled = enable;
+    upgradeFrames = UPGRADE_FRAMES;
+    upgraded = false;
+}
+
+void BloomGovernor::changeLevel(int next, const char* reason) {
+    std::cout << "Bloom governor: level " << level << " -> " << next << " (1/" << (1 << LEVELS[next].bloomScale)
+              << " resolution, " << static_cast<int>(LEVELS[next].radiusScale * 100.0f + 0.5f) << "% radius), "
+              << reason << ": " << std::fixed << std::setprecision(2) << smoothed << " of " << budget << " ms"
+              << std::endl;
+    
+    level = next;
+    post.setBloomScale(LEVELS[level].bloomScale);
+    settle = SETTLE_FRAMES;
+    overBudget = underBudget = 0;
+    framesAtLevel = 0;
+    upgraded = false;
+}
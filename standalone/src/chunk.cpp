@@ -0,0 +1,146 @@
+#include "chunk.h"
+
+#include <cmath>
+#include <random>
+
+static const BlockInfo BLOCK_INFO[BLOCK_TYPE_COUNT] = {
+    {"air", false, false},
+    {"glass", false, false},
+    {"stone", true, false},
+    {"deepslate", true, false},
+    {"netherrack", true, false},
+    {"coal_ore", true, true},
+    {"iron_ore", true, true},
+    {"gold_ore", true, true},
+    {"diamond_ore", true, true},
+    {"lapis_ore", true, true},
+    {"redstone_ore", true, true},
+    {"emerald_ore", true, true},
+    {"copper_ore", true, true},
+    {"deepslate_coal_ore", true, true},
+    {"deepslate_iron_ore", true, true},
+    {"deepslate_gold_ore", true, true},
+    {"deepslate_diamond_ore", true, true},
+    {"deepslate_lapis_ore", true, true},
+    {"deepslate_redstone_ore", true, true},
+    {"deepslate_emerald_ore", true, true},
+    {"deepslate_copper_ore", true, true},
+    {"nether_quartz_ore", true, true},
+    {"nether_gold_ore", true, true},
+    {"ancient_debris", true, true}
+};
+
+const BlockInfo& blockInfo(Block block) {
+    return BLOCK_INFO[static_cast<std::size_t>(block)];
+}
+
+Block deepslateVariant(Block ore) {
+    if (ore >= Block::CoalOre && ore <= Block::CopperOre) {
+        int offset = static_cast<int>(ore) - static_cast<int>(Block::CoalOre);
+        return static_cast<Block>(static_cast<int>(Block::DeepslateCoalOre) + offset);
+    }
+    return ore;
+}
+
+Chunk::Chunk(int sectionCount) : sections(sectionCount > 0 ? sectionCount : 1) {
+}
+
+Block Chunk::get(int x, int y, int z) const {
+    if (!contains(x, y, z)) {
+        return Block::Air;
+    }
+    return sections[y / SECTION_SIZE].blocks[ChunkSection::index(x, y % SECTION_SIZE, z)];
+}
+
+void Chunk::set(int x, int y, int z, Block block) {
+    if (!contains(x, y, z)) {
+        return;
+    }
+    ChunkSection& section = sections[y / SECTION_SIZE];
+    Block& current = section.blocks[ChunkSection::index(x, y % SECTION_SIZE, z)];
+    section.solidBlocks += (block != Block::Air) - (current != Block::Air);
+    current = block;
+}
+
+// Where each overworld ore spawns, as fractions of the surface height, and
+// how much of it: veins per 16 blocks of height and blocks per vein
+struct OreVein {
+    Block ore;
+    float minHeight, maxHeight;
+    int veinsPerSection;
+    int veinSize;
+};
+
+static const OreVein ORE_VEINS[] = {
+    {Block::CoalOre, 0.5f, 1.0f, 6, 10},
+    {Block::IronOre, 0.0f, 0.9f, 5, 7},
+    {Block::CopperOre, 0.3f, 0.8f, 4, 9},
+    {Block::GoldOre, 0.0f, 0.45f, 2, 6},
+    {Block::LapisOre, 0.0f, 0.5f, 1, 6},
+    {Block::RedstoneOre, 0.0f, 0.25f, 2, 7},
+    {Block::DiamondOre, 0.0f, 0.15f, 1, 5},
+    {Block::EmeraldOre, 0.6f, 1.0f, 1, 2}
+};
+
+void Chunk::generateTerrain(unsigned int seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> column(0, CHUNK_WIDTH - 1);
+    const int top = height();
+
+    // Rolling surface a few blocks below the top, deepslate in the bottom quarter
+    float phaseX = unit(random) * 6.28f, phaseZ = unit(random) * 6.28f;
+    int surface[CHUNK_WIDTH][CHUNK_WIDTH];
+    for (int x = 0; x < CHUNK_WIDTH; x++) {
+        for (int z = 0; z < CHUNK_WIDTH; z++) {
+            float wave = 2.0f * std::sin(x * 0.4f + phaseX) + 2.0f * std::cos(z * 0.3f + phaseZ);
+            int height = top - 6 + static_cast<int>(std::lround(wave));
+            surface[x][z] = height < 1 ? 1 : (height > top ? top : height);
+            for (int y = 0; y < surface[x][z]; y++) {
+                set(x, y, z, y < top / 4 ? Block::Deepslate : Block::Stone);
+            }
+        }
+    }
+
+    // Veins are short random walks that only replace rock; in deepslate the
+    // ore becomes its deepslate variant
+    for (const OreVein& vein : ORE_VEINS) {
+        int veins = vein.veinsPerSection * sectionCount();
+        for (int i = 0; i < veins; i++) {
+            int x = column(random);
+            int z = column(random);
+            float height = vein.minHeight + unit(random) * (vein.maxHeight - vein.minHeight);
+            int y = static_cast<int>(height * surface[x][z]);
+            for (int block = 0; block < vein.veinSize; block++) {
+                Block host = get(x, y, z);
+                if (host == Block::Stone) set(x, y, z, vein.ore);
+                if (host == Block::Deepslate) set(x, y, z, deepslateVariant(vein.ore));
+                int step = static_cast<int>(unit(random) * 6.0f);
+                int direction = step % 2 == 0 ? 1 : -1;
+                if (step < 2) x += direction;
+                else if (step < 4) y += direction;
+                else z += direction;
+            }
+        }
+    }
+
+    // Caves: air bubbles that cut through rock and ore alike
+    int caves = 2 * sectionCount();
+    for (int i = 0; i < caves; i++) {
+        float cx = unit(random) * CHUNK_WIDTH;
+        float cy = unit(random) * (top - 8);
+        float cz = unit(random) * CHUNK_WIDTH;
+        float radius = 1.5f + unit(random) * 2.5f;
+        int r = static_cast<int>(std::ceil(radius));
+        for (int y = static_cast<int>(cy) - r; y <= static_cast<int>(cy) + r; y++) {
+            for (int z = static_cast<int>(cz) - r; z <= static_cast<int>(cz) + r; z++) {
+                for (int x = static_cast<int>(cx) - r; x <= static_cast<int>(cx) + r; x++) {
+                    float dx = x + 0.5f - cx, dy = y + 0.5f - cy, dz = z + 0.5f - cz;
+                    if (dx * dx + dy * dy + dz * dz < radius * radius) {
+                        set(x, y, z, Block::Air);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,323 @@
+#include "chunk_mesher.h"
+
+#include <cstring>
+
+// One side of a block. The corners of its unit quad go counter-clockwise
+// seen from outside, with texture coordinates (0,0) (1,0) (1,1) (0,1); u runs
+// along uAxis and v along vAxis.
+struct BlockFace {
+    glm::ivec3 normal;
+    glm::vec3 corners[4];
+    int uAxis, vAxis;
+};
+
+static const BlockFace BLOCK_FACES[6] = {
+    {{-1, 0, 0}, {{0, 0, 0}, {0, 0, 1}, {0, 1, 1}, {0, 1, 0}}, 2, 1},
+    {{1, 0, 0}, {{1, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}}, 2, 1},
+    {{0, -1, 0}, {{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1}}, 0, 2},
+    {{0, 1, 0}, {{0, 1, 1}, {1, 1, 1}, {1, 1, 0}, {0, 1, 0}}, 0, 2},
+    {{0, 0, -1}, {{1, 0, 0}, {0, 0, 0}, {0, 1, 0}, {1, 1, 0}}, 0, 1},
+    {{0, 0, 1}, {{0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}}, 0, 1}
+};
+
+static const glm::vec2 FACE_TEXCOORDS[4] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+// Append a face of a box of size blocks at origin
+static void appendQuad(ChunkMeshData& data, int face, const glm::ivec3& origin, const glm::ivec3& size,
+                       std::uint32_t material) {
+    const BlockFace& side = BLOCK_FACES[face];
+    std::uint32_t base = static_cast<std::uint32_t>(data.vertices.size());
+    glm::vec2 repeat(static_cast<float>(size[side.uAxis]), static_cast<float>(size[side.vAxis]));
+    for (int i = 0; i < 4; i++) {
+        ChunkVertex vertex;
+        vertex.position = glm::vec3(origin) + side.corners[i] * glm::vec3(size);
+        vertex.normal = glm::vec3(side.normal);
+        vertex.texCoords = FACE_TEXCOORDS[i] * repeat;
+        vertex.material = material;
+        data.vertices.push_back(vertex);
+    }
+    const std::uint32_t quad[6] = {base, base + 1, base + 2, base + 2, base + 3, base};
+    data.indices.insert(data.indices.end(), quad, quad + 6);
+}
+
+// Whether a face of block shows against the block beside it
+static bool faceVisible(Block block, Block neighbor) {
+    return !blockInfo(neighbor).opaque && neighbor != block;
+}
+
+// A 16x16 slice of a section as a bitmask, bit v * 16 + u: each word holds
+// four rows of 16
+struct SliceMask {
+    std::uint64_t words[4];
+};
+
+// Slices along an axis, with the layer just outside the section on each side
+static const int PADDED_LAYERS = SECTION_SIZE + 2;
+
+// The slice coordinates of each axis: u runs along U_AXIS, v along V_AXIS
+static const int U_AXIS[3] = {2, 0, 0};
+static const int V_AXIS[3] = {1, 2, 1};
+
+// Every slice of one section along all three axes: what is opaque, and where
+// each block type is
+struct SectionMasks {
+    SliceMask opaque[3][PADDED_LAYERS];
+    SliceMask blocks[BLOCK_TYPE_COUNT][3][PADDED_LAYERS];
+    std::uint32_t present;      // Block types inside the section
+    std::uint32_t touched;      // Block types with any bit set, padding included
+};
+
+static_assert(BLOCK_TYPE_COUNT <= 32, "SectionMasks tracks block types in a 32-bit mask");
+
+static void setBit(SliceMask& mask, int u, int v) {
+    mask.words[v >> 2] |= std::uint64_t(1) << (((v & 3) << 4) | u);
+}
+
+static int trailingZeros(std::uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    int count = 0;
+    while (!(value & 1u)) {
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+static void markBlock(SectionMasks& masks, Block block, int axis, int layer, int u, int v) {
+    if (block == Block::Air) {
+        return;
+    }
+    std::size_t type = static_cast<std::size_t>(block);
+    setBit(masks.blocks[type][axis][layer], u, v);
+    masks.touched |= 1u << type;
+    if (blockInfo(block).opaque) {
+        setBit(masks.opaque[axis][layer], u, v);
+    }
+}
+
+// Cover the set bits of a slice with rectangles: take the lowest run of bits
+// in a row, then extend it down the rows below that contain the whole run
+static void mergeSlice(ChunkMeshData& data, const SliceMask& visible, int axis, int layer, int face,
+                       int sectionBase, std::uint32_t material) {
+    std::uint32_t rows[SECTION_SIZE];
+    for (int v = 0; v < SECTION_SIZE; v++) {
+        rows[v] = static_cast<std::uint32_t>(visible.words[v >> 2] >> ((v & 3) << 4)) & 0xFFFFu;
+    }
+    for (int v = 0; v < SECTION_SIZE; v++) {
+        while (rows[v] != 0) {
+            int start = trailingZeros(rows[v]);
+            int width = trailingZeros(~(rows[v] >> start));
+            std::uint32_t run = ((1u << width) - 1u) << start;
+            int height = 1;
+            while (v + height < SECTION_SIZE && (rows[v + height] & run) == run) {
+                rows[v + height] &= ~run;
+                height++;
+            }
+            rows[v] &= ~run;
+            
+            glm::ivec3 origin(0), size(1);
+            origin[axis] = layer;
+            origin[U_AXIS[axis]] = start;
+            origin[V_AXIS[axis]] = v;
+            origin.y += sectionBase;
+            size[U_AXIS[axis]] = width;
+            size[V_AXIS[axis]] = height;
+            appendQuad(data, face, origin, size, material);
+        }
+    }
+}
+
+ChunkMesher::ChunkMesher(const BlockPalette& palette, MeshingMode mode) : palette(palette), mode(mode) {
+}
+
+Block ChunkMesher::blockAt(const Chunk& chunk, const ChunkNeighbors& neighbors, int x, int y, int z) {
+    if (x < 0) return neighbors.negativeX ? neighbors.negativeX->get(x + CHUNK_WIDTH, y, z) : Block::Air;
+    if (x >= CHUNK_WIDTH) return neighbors.positiveX ? neighbors.positiveX->get(x - CHUNK_WIDTH, y, z) : Block::Air;
+    if (z < 0) return neighbors.negativeZ ? neighbors.negativeZ->get(x, y, z + CHUNK_WIDTH) : Block::Air;
+    if (z >= CHUNK_WIDTH) return neighbors.positiveZ ? neighbors.positiveZ->get(x, y, z - CHUNK_WIDTH) : Block::Air;
+    return chunk.get(x, y, z);
+}
+
+ChunkMeshData ChunkMesher::mesh(const Chunk& chunk, const ChunkNeighbors& neighbors) const {
+    ChunkMeshData data;
+    if (mode == MeshingMode::Greedy) {
+        meshGreedy(chunk, neighbors, data);
+    } else {
+        meshFaces(chunk, neighbors, data);
+    }
+    return data;
+}
+
+void ChunkMesher::meshFaces(const Chunk& chunk, const ChunkNeighbors& neighbors, ChunkMeshData& data) const {
+    for (int s = 0; s < chunk.sectionCount(); s++) {
+        const ChunkSection& section = chunk.section(s);
+        if (section.solidBlocks == 0) {
+            continue;
+        }
+        for (int y = 0; y < SECTION_SIZE; y++) {
+            for (int z = 0; z < CHUNK_WIDTH; z++) {
+                for (int x = 0; x < CHUNK_WIDTH; x++) {
+                    Block block = section.blocks[ChunkSection::index(x, y, z)];
+                    if (block == Block::Air) {
+                        continue;
+                    }
+                    glm::ivec3 position(x, s * SECTION_SIZE + y, z);
+                    std::uint32_t material = palette[static_cast<std::size_t>(block)];
+                    for (int face = 0; face < 6; face++) {
+                        glm::ivec3 beside = position + BLOCK_FACES[face].normal;
+                        if (faceVisible(block, blockAt(chunk, neighbors, beside.x, beside.y, beside.z))) {
+                            appendQuad(data, face, position, glm::ivec3(1), material);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkMesher::meshGreedy(const Chunk& chunk, const ChunkNeighbors& neighbors, ChunkMeshData& data) const {
+    // Too big for the stack; only the types a section touched are cleared
+    // before the next one
+    std::vector<SectionMasks> storage(1);
+    SectionMasks& masks = storage[0];
+    std::memset(&masks, 0, sizeof(SectionMasks));
+    
+    for (int s = 0; s < chunk.sectionCount(); s++) {
+        const ChunkSection& section = chunk.section(s);
+        if (section.solidBlocks == 0) {
+            continue;
+        }
+        int sectionBase = s * SECTION_SIZE;
+        
+        std::memset(masks.opaque, 0, sizeof(masks.opaque));
+        for (std::size_t type = 0; type < BLOCK_TYPE_COUNT; type++) {
+            if (masks.touched & (1u << type)) {
+                std::memset(masks.blocks[type], 0, sizeof(masks.blocks[type]));
+            }
+        }
+        masks.present = 0;
+        masks.touched = 0;
+        
+        // The section's own blocks go into all three axes' slices...
+        for (int y = 0; y < SECTION_SIZE; y++) {
+            for (int z = 0; z < CHUNK_WIDTH; z++) {
+                for (int x = 0; x < CHUNK_WIDTH; x++) {
+                    Block block = section.blocks[ChunkSection::index(x, y, z)];
+                    if (block == Block::Air) {
+                        continue;
+                    }
+                    masks.present |= 1u << static_cast<std::size_t>(block);
+                    const int position[3] = {x, y, z};
+                    for (int axis = 0; axis < 3; axis++) {
+                        markBlock(masks, block, axis, position[axis] + 1, position[U_AXIS[axis]], position[V_AXIS[axis]]);
+                    }
+                }
+            }
+        }
+        
+        // ...and the blocks just outside it only into the padding layers of
+        // the axis they lie along
+        for (int axis = 0; axis < 3; axis++) {
+            for (int layer = -1; layer <= SECTION_SIZE; layer += SECTION_SIZE + 1) {
+                for (int v = 0; v < SECTION_SIZE; v++) {
+                    for (int u = 0; u < SECTION_SIZE; u++) {
+                        int position[3];
+                        position[axis] = layer;
+                        position[U_AXIS[axis]] = u;
+                        position[V_AXIS[axis]] = v;
+                        Block block = blockAt(chunk, neighbors, position[0], sectionBase + position[1], position[2]);
+                        markBlock(masks, block, axis, layer + 1, u, v);
+                    }
+                }
+            }
+        }
+        
+        // A face shows where the block is and the next layer over is neither
+        // opaque nor the same block: four word operations per slice
+        for (std::size_t type = 0; type < BLOCK_TYPE_COUNT; type++) {
+            if (!(masks.present & (1u << type))) {
+                continue;
+            }
+            std::uint32_t material = palette[type];
+            for (int axis = 0; axis < 3; axis++) {
+                for (int layer = 0; layer < SECTION_SIZE; layer++) {
+                    const SliceMask& own = masks.blocks[type][axis][layer + 1];
+                    if ((own.words[0] | own.words[1] | own.words[2] | own.words[3]) == 0) {
+                        continue;
+                    }
+                    for (int side = 0; side < 2; side++) {
+                        int next = side == 0 ? layer : layer + 2;
+                        const SliceMask& opaque = masks.opaque[axis][next];
+                        const SliceMask& same = masks.blocks[type][axis][next];
+                        SliceMask visible;
+                        std::uint64_t any = 0;
+                        for (int i = 0; i < 4; i++) {
+                            visible.words[i] = own.words[i] & ~(opaque.words[i] | same.words[i]);
+                            any |= visible.words[i];
+                        }
+                        if (any != 0) {
+                            mergeSlice(data, visible, axis, layer, axis * 2 + side, sectionBase, material);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::size_t ChunkMesher::naiveQuadCount(const Chunk& chunk) {
+    std::size_t blocks = 0;
+    for (int s = 0; s < chunk.sectionCount(); s++) {
+        blocks += chunk.section(s).solidBlocks;
+    }
+    return blocks * 6;
+}
+
+ChunkMesh::ChunkMesh() : vao(0), vertexBuffer(0), indexBuffer(0), indexCount(0) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, texCoords));
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, material));
+    glEnableVertexAttribArray(4);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+ChunkMesh::~ChunkMesh() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+}
+
+void ChunkMesh::upload(const ChunkMeshData& data) {
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(ChunkVertex), data.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // The element buffer is VAO state, so bind the VAO to replace it
+    glBindVertexArray(vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(std::uint32_t), data.indices.data(),
+                 GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    indexCount = data.indices.size();
+}
+
+void ChunkMesh::draw() const {
+    if (indexCount == 0) {
+        return;
+    }
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, (void*)0);
+}
@@ -0,0 +1,146 @@
+#include "color_grading.h"
+#include "gl_debug.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+// Rec. 709 luma weights, as in lib/luminance.glsl
+static const glm::vec3 LUMINANCE_WEIGHTS(0.2126f, 0.7152f, 0.0722f);
+static const float MIDDLE_GRAY = 0.18f;
+
+static glm::vec3 toneMapACES(glm::vec3 x) {
+    // Narkowicz 2015; the fit includes the curve's 0.6 exposure scale
+    x *= 0.6f;
+    return glm::clamp((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f), 0.0f, 1.0f);
+}
+
+static glm::vec3 hable(glm::vec3 x) {
+    const float A = 0.15f, B = 0.50f, C = 0.10f, D = 0.20f, E = 0.02f, F = 0.30f;
+    return ((x * (A * x + C * B) + D * E) / (x * (A * x + B) + D * F)) - E / F;
+}
+
+static glm::vec3 toneMapFilmic(glm::vec3 x) {
+    const float EXPOSURE_BIAS = 2.0f;
+    const float WHITE = 11.2f;
+    return glm::clamp(hable(x * EXPOSURE_BIAS) / hable(glm::vec3(WHITE)), 0.0f, 1.0f);
+}
+
+static glm::vec3 toneMap(ToneMapOperator op, glm::vec3 x) {
+    switch (op) {
+        case ToneMapOperator::ACES: return toneMapACES(x);
+        case ToneMapOperator::Filmic: return toneMapFilmic(x);
+        case ToneMapOperator::Linear: return glm::clamp(x, 0.0f, 1.0f);
+        default: return x / (x + 1.0f);
+    }
+}
+
+// The whole grading chain for one scene-linear color
+static glm::vec3 grade(const GradingParameters& p, glm::vec3 color) {
+    color *= std::exp2(p.exposure);
+    
+    // White balance: a crude warm/cool shift that keeps luminance
+    glm::vec3 balance(1.0f + 0.1f * p.temperature, 1.0f, 1.0f - 0.1f * p.temperature);
+    color = color * (balance / glm::dot(balance, LUMINANCE_WEIGHTS));
+    
+    float luma = glm::dot(color, LUMINANCE_WEIGHTS);
+    color = glm::max(glm::mix(glm::vec3(luma), color, p.saturation), 0.0f);
+    
+    // Contrast as a power curve pivoting on middle gray
+    if (p.contrast != 1.0f) {
+        color = MIDDLE_GRAY * glm::pow(color / MIDDLE_GRAY, glm::vec3(p.contrast));
+    }
+    return toneMap(p.toneMap, color);
+}
+
+bool GradingParameters::operator==(const GradingParameters& other) const {
+    return toneMap == other.toneMap && exposure == other.exposure && contrast == other.contrast &&
+           saturation == other.saturation && temperature == other.temperature;
+}
+
+const char* toneMapOperatorName(ToneMapOperator op) {
+    switch (op) {
+        case ToneMapOperator::ACES: return "ACES";
+        case ToneMapOperator::Filmic: return "filmic";
+        case ToneMapOperator::Linear: return "linear";
+        default: return "Reinhard";
+    }
+}
+
+ColorGrading::ColorGrading() : dirty(true), lut(0), bakeMilliseconds(0.0) {
+    texels.resize(LUT_SIZE * LUT_SIZE * LUT_SIZE * 3);
+    
+    glGenTextures(1, &lut);
+    glBindTexture(GL_TEXTURE_3D, lut);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, LUT_SIZE, LUT_SIZE, LUT_SIZE, 0, GL_RGB, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+ColorGrading::~ColorGrading() {
+    glDeleteTextures(1, &lut);
+}
+
+void ColorGrading::setParameters(const GradingParameters& newParameters) {
+    if (newParameters != parameters) {
+        parameters = newParameters;
+        dirty = true;
+    }
+}
+
+bool ColorGrading::update() {
+    if (!dirty) {
+        return false;
+    }
+    GL_SCOPE("ColorGrading::update");
+    auto start = std::chrono::steady_clock::now();
+    
+    // Each thread bakes a contiguous run of blue slices
+    int threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max(1, std::min(threadCount, LUT_SIZE));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&ColorGrading::bakeSlices, this, i * LUT_SIZE / threadCount,
+                             (i + 1) * LUT_SIZE / threadCount);
+    }
+    bakeSlices(0, LUT_SIZE / threadCount);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    glBindTexture(GL_TEXTURE_3D, lut);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, LUT_SIZE, LUT_SIZE, LUT_SIZE, GL_RGB, GL_FLOAT, texels.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    
+    dirty = false;
+    bakeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Baked " << toneMapOperatorName(parameters.toneMap) << " grading LUT on " << threadCount
+              << " threads in " << bakeMilliseconds << " ms" << std::endl;
+    return true;
+}
+
+void ColorGrading::bakeSlices(int first, int last) {
+    // Texel centers sit at i / (LUT_SIZE - 1) of the log2 range, matching the
+    // shader's half-texel scale and bias
+    float step = (MAX_EV - MIN_EV) / (LUT_SIZE - 1);
+    for (int b = first; b < last; b++) {
+        for (int g = 0; g < LUT_SIZE; g++) {
+            for (int r = 0; r < LUT_SIZE; r++) {
+                glm::vec3 color(std::exp2(MIN_EV + r * step), std::exp2(MIN_EV + g * step), std::exp2(MIN_EV + b * step));
+                glm::vec3 graded = grade(parameters, color);
+                float* texel = &texels[((b * LUT_SIZE + g) * LUT_SIZE + r) * 3];
+                texel[0] = graded.r;
+                texel[1] = graded.g;
+                texel[2] = graded.b;
+            }
+        }
+    }
+}
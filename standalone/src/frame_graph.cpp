@@ -0,0 +1,404 @@
+#include "frame_graph.h"
+#include "gl_debug.h"
+
+#include <algorithm>
+#include <iomanip>
+
+static const GLuint UNKNOWN_FRAMEBUFFER = ~0u;
+
+static const char* formatName(GLenum format) {
+    switch (format) {
+        case GL_RGBA8: return "RGBA8";
+        case GL_RGBA16F: return "RGBA16F";
+        case GL_RGBA32F: return "RGBA32F";
+        case GL_R11F_G11F_B10F: return "R11F_G11F_B10F";
+        case GL_DEPTH_COMPONENT24: return "DEPTH24";
+        case GL_DEPTH24_STENCIL8: return "DEPTH24_STENCIL8";
+        case GL_DEPTH_COMPONENT32F: return "DEPTH32F";
+        default: return "other";
+    }
+}
+
+GLuint FrameGraph::Context::texture(FrameResource resource) const {
+    const Resource& entry = graph.resources[resource];
+    return entry.imported ? entry.texture : graph.slots[entry.slot].target->texture;
+}
+
+GLuint FrameGraph::Context::framebuffer(FrameResource resource) const {
+    const Resource& entry = graph.resources[resource];
+    return entry.imported ? entry.framebuffer : graph.slots[entry.slot].target->fbo;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::read(FrameResource resource) {
+    graph.passes[pass].reads.push_back(resource);
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::write(FrameResource resource) {
+    graph.passes[pass].writes.push_back(resource);
+    if (resource == graph.backbuffer) {
+        graph.passes[pass].sideEffect = true;
+    }
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::depthTest(bool enabled) {
+    graph.passes[pass].state.depthTest = enabled;
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::blend(GLenum source, GLenum destination) {
+    return blend(source, destination, source, destination);
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::blend(GLenum source, GLenum destination,
+                                                         GLenum alphaSource, GLenum alphaDestination) {
+    PassState& state = graph.passes[pass].state;
+    state.blend = true;
+    state.blendSource = source;
+    state.blendDestination = destination;
+    state.blendAlphaSource = alphaSource;
+    state.blendAlphaDestination = alphaDestination;
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::compute() {
+    graph.passes[pass].compute = true;
+    return *this;
+}
+
+FrameGraph::PassBuilder& FrameGraph::PassBuilder::sideEffect() {
+    graph.passes[pass].sideEffect = true;
+    return *this;
+}
+
+FrameGraph::FrameGraph(RenderTargetPool& pool)
+    : pool(pool), backbuffer(NO_FRAME_RESOURCE), compiled(false), stateKnown(false),
+      boundFramebuffer(UNKNOWN_FRAMEBUFFER), viewportWidth(0), viewportHeight(0) {
+}
+
+FrameGraph::~FrameGraph() {
+    releaseSlots();
+}
+
+FrameResource FrameGraph::createTarget(const std::string& name, const RenderTargetDesc& desc) {
+    resources.push_back({name, desc, false, true, 0, 0, GL_COLOR_ATTACHMENT0, 0, -1, -1, -1});
+    compiled = false;
+    return static_cast<FrameResource>(resources.size() - 1);
+}
+
+FrameResource FrameGraph::importTarget(const std::string& name, GLuint texture, const RenderTargetDesc& desc,
+                                       GLuint framebuffer, GLenum attachment, bool discardable) {
+    resources.push_back({name, desc, true, discardable, texture, framebuffer, attachment, 0, -1, -1, -1});
+    compiled = false;
+    return static_cast<FrameResource>(resources.size() - 1);
+}
+
+FrameResource FrameGraph::importBackbuffer(unsigned int width, unsigned int height) {
+    if (backbuffer == NO_FRAME_RESOURCE) {
+        backbuffer = importTarget("backbuffer", 0, {width, height, GL_RGBA8, 1}, 0, GL_BACK, false);
+    }
+    return backbuffer;
+}
+
+FrameGraph::PassBuilder FrameGraph::addPass(const std::string& name, PassFunction run) {
+    Pass pass;
+    pass.name = name;
+    pass.run = std::move(run);
+    passes.push_back(std::move(pass));
+    compiled = false;
+    return PassBuilder(*this, static_cast<int>(passes.size() - 1));
+}
+
+void FrameGraph::compile() {
+    cull();
+    assignLifetimes();
+    assignSlots();
+    compiled = true;
+}
+
+void FrameGraph::cull() {
+    for (Resource& resource : resources) {
+        resource.readers = 0;
+    }
+    for (Pass& pass : passes) {
+        pass.culled = false;
+        pass.references = static_cast<int>(pass.writes.size());
+        for (FrameResource resource : pass.reads) {
+            resources[resource].readers++;
+        }
+    }
+
+    // Walk back from every resource nobody reads: its writers lose a
+    // reference, and a writer left with none drops its own reads in turn
+    std::vector<FrameResource> unread;
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        if (resources[i].readers == 0) {
+            unread.push_back(static_cast<FrameResource>(i));
+        }
+    }
+    while (!unread.empty()) {
+        FrameResource resource = unread.back();
+        unread.pop_back();
+        for (Pass& pass : passes) {
+            if (pass.culled || pass.sideEffect ||
+                std::find(pass.writes.begin(), pass.writes.end(), resource) == pass.writes.end()) {
+                continue;
+            }
+            if (--pass.references > 0) {
+                continue;
+            }
+            pass.culled = true;
+            for (FrameResource input : pass.reads) {
+                if (--resources[input].readers == 0) {
+                    unread.push_back(input);
+                }
+            }
+        }
+    }
+}
+
+void FrameGraph::assignLifetimes() {
+    for (Resource& resource : resources) {
+        resource.firstUse = resource.lastUse = -1;
+    }
+    for (std::size_t i = 0; i < passes.size(); i++) {
+        Pass& pass = passes[i];
+        pass.discards.clear();
+        if (pass.culled) {
+            continue;
+        }
+        int index = static_cast<int>(i);
+        for (const std::vector<FrameResource>* list : {&pass.reads, &pass.writes}) {
+            for (FrameResource resource : *list) {
+                Resource& entry = resources[resource];
+                if (entry.firstUse < 0) entry.firstUse = index;
+                entry.lastUse = index;
+            }
+        }
+    }
+
+    // Contents only needed within the frame can be dropped after their last use
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (resource.lastUse >= 0 && resource.discardable) {
+            passes[resource.lastUse].discards.push_back(static_cast<FrameResource>(i));
+        }
+    }
+}
+
+void FrameGraph::assignSlots() {
+    releaseSlots();
+    slots.clear();
+
+    std::vector<FrameResource> transient;
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        resources[i].slot = -1;
+        if (!resources[i].imported && resources[i].firstUse >= 0) {
+            transient.push_back(static_cast<FrameResource>(i));
+        }
+    }
+    std::stable_sort(transient.begin(), transient.end(), [this](FrameResource a, FrameResource b) {
+        return resources[a].firstUse < resources[b].firstUse;
+    });
+
+    // First fit: reuse a texture of the same description whose previous
+    // resource was last used before this one is first written
+    for (FrameResource index : transient) {
+        Resource& resource = resources[index];
+        for (std::size_t s = 0; s < slots.size(); s++) {
+            if (slots[s].desc == resource.desc && slots[s].lastUse < resource.firstUse) {
+                resource.slot = static_cast<int>(s);
+                break;
+            }
+        }
+        if (resource.slot < 0) {
+            slots.push_back({resource.desc, nullptr, resource.firstUse, resource.lastUse});
+            resource.slot = static_cast<int>(slots.size() - 1);
+        }
+        slots[resource.slot].lastUse = resource.lastUse;
+    }
+}
+
+void FrameGraph::execute(GpuPassTimer* timer) {
+    if (!compiled) {
+        compile();
+    }
+    if (timer) {
+        timer->beginFrame();
+    }
+
+    // Whatever ran before the graph may have changed any of it
+    stateKnown = false;
+    boundFramebuffer = UNKNOWN_FRAMEBUFFER;
+    viewportWidth = viewportHeight = 0;
+
+    Context context(*this);
+    for (std::size_t i = 0; i < passes.size(); i++) {
+        const Pass& pass = passes[i];
+        if (pass.culled) {
+            continue;
+        }
+        int index = static_cast<int>(i);
+        for (Slot& slot : slots) {
+            if (slot.firstUse == index) {
+                slot.target = pool.acquire(slot.desc);
+            }
+        }
+
+        if (timer) {
+            timer->beginPass(pass.name);
+        }
+        {
+            GL_SCOPE(pass.name.c_str());
+            applyState(pass);
+            pass.run(context);
+        }
+
+        for (FrameResource resource : pass.discards) {
+            discard(resource);
+        }
+        for (Slot& slot : slots) {
+            if (slot.lastUse == index) {
+                pool.release(slot.target);
+                slot.target = nullptr;
+            }
+        }
+    }
+    if (timer) {
+        timer->endFrame();
+    }
+    pool.endFrame();
+}
+
+void FrameGraph::reset() {
+    releaseSlots();
+    resources.clear();
+    passes.clear();
+    slots.clear();
+    backbuffer = NO_FRAME_RESOURCE;
+    compiled = false;
+}
+
+void FrameGraph::applyState(const Pass& pass) {
+    if (!pass.compute && !pass.writes.empty()) {
+        const Resource& target = resources[pass.writes.front()];
+        GLuint framebuffer = target.imported ? target.framebuffer : slots[target.slot].target->fbo;
+        if (framebuffer != boundFramebuffer) {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+            boundFramebuffer = framebuffer;
+        }
+        if (target.desc.width != viewportWidth || target.desc.height != viewportHeight) {
+            glViewport(0, 0, target.desc.width, target.desc.height);
+            viewportWidth = target.desc.width;
+            viewportHeight = target.desc.height;
+        }
+    }
+
+    const PassState& state = pass.state;
+    if (!stateKnown || state.depthTest != currentState.depthTest) {
+        if (state.depthTest) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+    }
+    if (!stateKnown || state.blend != currentState.blend) {
+        if (state.blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    }
+    if (state.blend && (!stateKnown || !currentState.blend || state.blendSource != currentState.blendSource ||
+                        state.blendDestination != currentState.blendDestination ||
+                        state.blendAlphaSource != currentState.blendAlphaSource ||
+                        state.blendAlphaDestination != currentState.blendAlphaDestination)) {
+        glBlendFuncSeparate(state.blendSource, state.blendDestination,
+                            state.blendAlphaSource, state.blendAlphaDestination);
+    }
+    currentState = state;
+    stateKnown = true;
+}
+
+void FrameGraph::discard(FrameResource resource) {
+    if (!GLEW_VERSION_4_3 && !GLEW_ARB_invalidate_subdata) {
+        return;
+    }
+    const Resource& entry = resources[resource];
+    GLuint framebuffer = entry.imported ? entry.framebuffer : slots[entry.slot].target->fbo;
+    // The read binding is free for this; the draw binding belongs to the passes
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 1, &entry.attachment);
+}
+
+void FrameGraph::releaseSlots() {
+    for (Slot& slot : slots) {
+        if (slot.target) {
+            pool.release(slot.target);
+            slot.target = nullptr;
+        }
+    }
+}
+
+std::size_t FrameGraph::bytesMoved() const {
+    std::size_t bytes = 0;
+    for (const Pass& pass : passes) {
+        if (pass.culled) {
+            continue;
+        }
+        for (FrameResource resource : pass.reads) {
+            bytes += RenderTargetPool::sizeOf(resources[resource].desc);
+        }
+        for (FrameResource resource : pass.writes) {
+            bytes += RenderTargetPool::sizeOf(resources[resource].desc);
+        }
+    }
+    return bytes;
+}
+
+void FrameGraph::dump(std::ostream& out) const {
+    int culled = 0;
+    int transient = 0;
+    std::size_t bytes = 0;
+    for (const Pass& pass : passes) {
+        if (pass.culled) culled++;
+    }
+    for (const Resource& resource : resources) {
+        if (!resource.imported && resource.slot >= 0) transient++;
+    }
+    for (const Slot& slot : slots) {
+        bytes += RenderTargetPool::sizeOf(slot.desc);
+    }
+
+    auto names = [this](const std::vector<FrameResource>& list) {
+        std::string text;
+        for (FrameResource resource : list) {
+            text += (text.empty() ? "" : ", ") + resources[resource].name;
+        }
+        return text.empty() ? std::string("-") : text;
+    };
+
+    out << "Frame graph" << (compiled ? "" : " (not compiled)") << ": " << passes.size() << " passes ("
+        << culled << " culled), " << transient << " transient targets in " << slots.size() << " textures ("
+        << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MB), about "
+        << bytesMoved() / (1024.0 * 1024.0) << " MB moved" << std::endl;
+    for (std::size_t i = 0; i < passes.size(); i++) {
+        const Pass& pass = passes[i];
+        out << "  " << std::setw(2) << i << " " << pass.name;
+        if (pass.culled) out << " [culled]";
+        if (pass.compute) out << " [compute]";
+        if (pass.state.depthTest) out << " [depth]";
+        if (pass.state.blend) out << " [blend]";
+        out << "\n       reads " << names(pass.reads) << "; writes " << names(pass.writes);
+        if (!pass.discards.empty()) out << "; discards " << names(pass.discards);
+        out << std::endl;
+    }
+    for (const Resource& resource : resources) {
+        out << "  " << resource.name << " " << resource.desc.width << "x" << resource.desc.height << " "
+            << formatName(resource.desc.format);
+        if (resource.firstUse < 0) {
+            out << ", unused";
+        } else {
+            out << ", passes " << resource.firstUse << "-" << resource.lastUse;
+        }
+        if (resource.imported) {
+            out << ", imported";
+        } else if (resource.slot >= 0) {
+            out << ", texture " << resource.slot;
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,72 @@
+#include "gaussian_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+GaussianKernel::GaussianKernel(int radius, float sigma) {
+    if (radius < 1) radius = 1;
+    deviation = sigma > 0.0f ? sigma : radius / 3.0f;
+
+    discrete.resize(radius + 1);
+    float total = 0.0f;
+    for (int i = 0; i <= radius; i++) {
+        discrete[i] = std::exp(-(i * i) / (2.0f * deviation * deviation));
+        // Every offset but the center appears on both sides
+        total += i == 0 ? discrete[i] : 2.0f * discrete[i];
+    }
+    for (float& weight : discrete) {
+        weight /= total;
+    }
+}
+
+std::vector<GaussianKernel::Tap> GaussianKernel::bilinearTaps() const {
+    std::vector<Tap> taps;
+    taps.push_back({0.0f, discrete[0]});
+
+    // A linear fetch at offset o between texels i and i + 1 returns
+    // (i + 1 - o) * t[i] + (o - i) * t[i + 1]; placing o at the weighted
+    // center of the pair reproduces both discrete weights with one fetch
+    int last = radius();
+    for (int i = 1; i <= last; i += 2) {
+        if (i == last) {
+            taps.push_back({static_cast<float>(i), discrete[i]});
+            break;
+        }
+        float weight = discrete[i] + discrete[i + 1];
+        float offset = (i * discrete[i] + (i + 1) * discrete[i + 1]) / weight;
+        taps.push_back({offset, weight});
+    }
+    return taps;
+}
+
+std::vector<GaussianKernel::Tap> GaussianKernel::interleavedTaps(int phase, int phases) const {
+    std::vector<Tap> all = bilinearTaps();
+    if (phases < 2) {
+        return all;
+    }
+    std::vector<Tap> taps;
+    taps.push_back(all[0]);
+    
+    // The other taps, weights scaled by phases, are laid end to end in
+    // interleaved order (every phases-th tap from the first, then from the
+    // second, ...) and cut into phases equal lengths, one per phase; a tap
+    // straddling a cut is split between the two. Each phase then holds one
+    // side's worth of the off-center weight, and each tap's weight summed
+    // over the phases is phases times its own.
+    float length = (1.0f - all[0].weight) / 2.0f;
+    float start = phase * length;
+    float end = phase == phases - 1 ? 2.0f * phases : start + length;  // Rounding goes to the last phase
+    float position = 0.0f;
+    for (int first = 1; first <= phases; first++) {
+        for (std::size_t i = first; i < all.size(); i += phases) {
+            float mass = all[i].weight * phases;
+            float from = std::max(position, start);
+            float to = std::min(position + mass, end);
+            if (to - from > 1e-6f) {
+                taps.push_back({all[i].offset, to - from});
+            }
+            position += mass;
+        }
+    }
+    return taps;
+}
@@ -0,0 +1,106 @@
+#include "gl_debug.h"
+#include "logger.h"
+
+#include <cstring>
+#include <sstream>
+
+bool GLDebug::installed = false;
+
+// Innermost GL_SCOPE tag on this thread
+static thread_local const char* currentTag = nullptr;
+
+static const char* sourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION: return "application";
+        default: return "other";
+    }
+}
+
+static const char* typeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        default: return "other";
+    }
+}
+
+bool GLDebug::install(bool synchronous) {
+    if (!GLEW_KHR_debug && !GLEW_VERSION_4_3) {
+        Logger::info("GL debug output not available, using glGetError checks in debug builds");
+        return false;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    if (synchronous) {
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    } else {
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    glDebugMessageCallback(callback, nullptr);
+
+    // Notifications (buffer placement hints and the like) are just noise
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+    // Our own debug groups echo back as push/pop messages; skip those too
+    glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+    glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+
+    installed = true;
+    Logger::info(std::string("GL debug output installed (") + (synchronous ? "synchronous" : "asynchronous") + ")");
+    return true;
+}
+
+void GLDebug::check(const char* tag) {
+    if (installed) {
+        return;
+    }
+
+    GLenum error;
+    while ((error = glGetError()) != GL_NO_ERROR) {
+        std::ostringstream message;
+        message << "OpenGL error after " << tag << ": " << error
+                << " (0x" << std::hex << error << std::dec << ")";
+        Logger::error(message.str());
+    }
+}
+
+GLDebug::Scope::Scope(const char* tag) : previous(currentTag) {
+    currentTag = tag;
+    if (installed) {
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, tag);
+    }
+}
+
+GLDebug::Scope::~Scope() {
+    if (installed) {
+        glPopDebugGroup();
+    }
+    currentTag = previous;
+}
+
+void APIENTRY GLDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                GLsizei length, const GLchar* message, const void* /*userParam*/) {
+    // In asynchronous mode the driver may call us from its own thread, where
+    // no scope is active; synchronous mode always has the caller's tag
+    std::ostringstream text;
+    text << "GL " << sourceName(source) << " " << typeName(type) << " #" << id;
+    if (currentTag) {
+        text << " in " << currentTag;
+    }
+    text << ": ";
+    text.write(message, length >= 0 ? length : static_cast<std::streamsize>(std::strlen(message)));
+
+    if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH) {
+        Logger::error(text.str());
+    } else if (severity == GL_DEBUG_SEVERITY_MEDIUM) {
+        Logger::warning(text.str());
+    } else {
+        Logger::debug(text.str());
+    }
+}
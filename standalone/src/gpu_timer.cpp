@@ -0,0 +1,152 @@
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer() : current(0), active(false), last(0.0), total(0.0), samples(0) {
+    glGenQueries(QUERY_COUNT, queries);
+    for (unsigned int i = 0; i < QUERY_COUNT; i++) {
+        inFlight[i] = false;
+    }
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(QUERY_COUNT, queries);
+}
+
+void GpuTimer::begin() {
+    collect();
+
+    // Skip this measurement rather than wait for the GPU to catch up
+    if (inFlight[current]) {
+        return;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+    active = true;
+}
+
+void GpuTimer::end() {
+    if (!active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    inFlight[current] = true;
+    current = (current + 1) % QUERY_COUNT;
+    active = false;
+}
+
+void GpuTimer::reset() {
+    total = 0.0;
+    samples = 0;
+}
+
+void GpuTimer::collect() {
+    for (unsigned int i = 0; i < QUERY_COUNT; i++) {
+        if (!inFlight[i]) {
+            continue;
+        }
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &nanoseconds);
+        inFlight[i] = false;
+
+        last = nanoseconds / 1.0e6;
+        total += last;
+        samples++;
+    }
+}
+
+GpuPassTimer::GpuPassTimer() : current(0), recording(false), frames(0) {
+}
+
+GpuPassTimer::~GpuPassTimer() {
+    for (Frame& frame : ring) {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+}
+
+void GpuPassTimer::beginFrame() {
+    collect();
+
+    // Skip this frame rather than wait for the GPU to catch up
+    Frame& frame = ring[current];
+    recording = !frame.inFlight;
+    if (recording) {
+        frame.used = 0;
+        frame.names.clear();
+    }
+}
+
+void GpuPassTimer::beginPass(const std::string& name) {
+    if (!recording) {
+        return;
+    }
+    ring[current].names.push_back(name);
+    mark();
+}
+
+void GpuPassTimer::endFrame() {
+    if (!recording) {
+        return;
+    }
+    Frame& frame = ring[current];
+    if (!frame.names.empty()) {
+        mark();
+        frame.inFlight = true;
+        current = (current + 1) % FRAME_COUNT;
+    }
+    recording = false;
+}
+
+double GpuPassTimer::milliseconds(const std::string& prefix) const {
+    double total = 0.0;
+    for (const PassTime& pass : last) {
+        if (pass.name.compare(0, prefix.size(), prefix) == 0) {
+            total += pass.milliseconds;
+        }
+    }
+    return total;
+}
+
+void GpuPassTimer::mark() {
+    Frame& frame = ring[current];
+    if (frame.used == frame.queries.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    glQueryCounter(frame.queries[frame.used++], GL_TIMESTAMP);
+}
+
+void GpuPassTimer::collect() {
+    // Oldest first; frames finish in order, so stop at the first one still running
+    for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+        Frame& frame = ring[(current + i) % FRAME_COUNT];
+        if (!frame.inFlight) {
+            continue;
+        }
+
+        // Timestamps land in order too: the last one covers the whole frame
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return;
+        }
+
+        std::vector<GLuint64> stamps(frame.used);
+        for (unsigned int q = 0; q < frame.used; q++) {
+            glGetQueryObjectui64v(frame.queries[q], GL_QUERY_RESULT, &stamps[q]);
+        }
+        last.clear();
+        for (std::size_t p = 0; p < frame.names.size(); p++) {
+            last.push_back({frame.names[p], (stamps[p + 1] - stamps[p]) / 1.0e6});
+        }
+        frame.inFlight = false;
+        frames++;
+    }
+}
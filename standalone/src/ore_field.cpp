@@ -0,0 +1,214 @@
+#include "ore_field.h"
+#include "gl_debug.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// Four corners per face so each face keeps its own normal and texture
+// coordinates; counter-clockwise seen from outside
+static const float CUBE_VERTICES[] = {
+    // positions          // normals           // texture coords
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 1.0f,
+
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+static const GLsizei CUBE_INDEX_COUNT = 36;
+
+OreFieldRenderer::OreFieldRenderer(const std::vector<OreMaterial>& materials)
+    : vao(0), vertexBuffer(0), indexBuffer(0), instanceBuffer(0), diffuseArray(0), emissiveArray(0),
+      materialBlock(ORE_MATERIAL_BLOCK_BINDING, 2), instances(0),
+      oreTypes(static_cast<int>(materials.size()) < MAX_ORE_TYPES ? static_cast<int>(materials.size()) : MAX_ORE_TYPES) {
+    if (static_cast<int>(materials.size()) > MAX_ORE_TYPES) {
+        std::cerr << "Ore field: only the first " << MAX_ORE_TYPES << " of " << materials.size()
+                  << " ore types are drawn" << std::endl;
+    }
+    GL_SCOPE("ore field setup");
+    initMesh();
+
+    std::vector<OreMaterial> used(materials.begin(), materials.begin() + oreTypes);
+    diffuseArray = buildTextureArray(used, &OreMaterial::diffuseMap);
+    emissiveArray = buildTextureArray(used, &OreMaterial::emissiveMap);
+
+    // The materials never change, so the block is written once and stays bound
+    OreMaterialConstants constants = {};
+    for (int i = 0; i < oreTypes; i++) {
+        constants.ores[i] = glm::vec4(used[i].color, used[i].glowStrength);
+    }
+    materialBlock.update(constants);
+}
+
+OreFieldRenderer::~OreFieldRenderer() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteTextures(1, &diffuseArray);
+    glDeleteTextures(1, &emissiveArray);
+}
+
+void OreFieldRenderer::initMesh() {
+    std::vector<GLushort> indices;
+    for (GLushort face = 0; face < 6; face++) {
+        GLushort base = face * 4;
+        GLushort quad[6] = {base, GLushort(base + 1), GLushort(base + 2),
+                            GLushort(base + 2), GLushort(base + 3), base};
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glGenBuffers(1, &instanceBuffer);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+
+    // Same per-vertex layout as the single cube
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // Per-instance offset and ore type, advancing once per cube
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(OreInstance), (void*)offsetof(OreInstance, position));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(OreInstance), (void*)offsetof(OreInstance, oreType));
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint OreFieldRenderer::buildTextureArray(const std::vector<OreMaterial>& materials, GLuint OreMaterial::*map) {
+    GLuint array;
+    glGenTextures(1, &array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TEXTURE_SIZE, TEXTURE_SIZE, static_cast<GLsizei>(materials.size()),
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // Blit each source into its layer, which also rescales any texture that
+    // isn't TEXTURE_SIZE square and converts its format (a single-channel
+    // mask keeps its red channel, which is all the glowing shader reads)
+    GLuint framebuffers[2];
+    glGenFramebuffers(2, framebuffers);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]);
+    for (std::size_t layer = 0; layer < materials.size(); layer++) {
+        GLuint source = materials[layer].*map;
+        if (source == 0) continue;
+
+        GLint width = 0, height = 0;
+        glBindTexture(GL_TEXTURE_2D, source);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array, 0, static_cast<GLint>(layer));
+        glBlitFramebuffer(0, 0, width, height, 0, 0, TEXTURE_SIZE, TEXTURE_SIZE, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, framebuffers);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Distant blocks cover a few pixels each, so unlike the single cube the
+    // field needs mipmaps; magnification stays pixelated
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return array;
+}
+
+void OreFieldRenderer::setInstances(const std::vector<OreInstance>& blocks) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, blocks.size() * sizeof(OreInstance), blocks.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instances = blocks.size();
+}
+
+void OreFieldRenderer::draw() const {
+    if (instances == 0) {
+        return;
+    }
+    bindMaterials();
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES, CUBE_INDEX_COUNT, GL_UNSIGNED_SHORT, (void*)0,
+                            static_cast<GLsizei>(instances));
+}
+
+void OreFieldRenderer::bindMaterials() const {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, diffuseArray);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, emissiveArray);
+}
+
+int OreFieldRenderer::fieldSide(std::size_t count) {
+    int side = static_cast<int>(std::cbrt(static_cast<double>(count)));
+    while (static_cast<std::size_t>(side) * side * side < count) {
+        side++;
+    }
+    return side;
+}
+
+std::vector<OreInstance> OreFieldRenderer::generateField(std::size_t count, int oreTypes, float spacing,
+                                                         unsigned int seed) {
+    std::vector<OreInstance> blocks(count);
+    if (count == 0 || oreTypes <= 0) {
+        blocks.clear();
+        return blocks;
+    }
+
+    // Fill the cube layer by layer; a partial last layer sits at the top
+    std::size_t side = static_cast<std::size_t>(fieldSide(count));
+    float center = (side - 1) * spacing * 0.5f;
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<std::uint32_t> type(0, static_cast<std::uint32_t>(oreTypes - 1));
+    for (std::size_t i = 0; i < count; i++) {
+        std::size_t x = i % side;
+        std::size_t z = (i / side) % side;
+        std::size_t y = i / (side * side);
+        blocks[i].position = glm::vec3(x * spacing - center, y * spacing - center, z * spacing - center);
+        blocks[i].oreType = type(random);
+    }
+    return blocks;
+}
@@ -1,56 +1,137 @@
 #include "post_processor.h"
+#include "gl_debug.h"
+#include "embedded_shaders.h"
+#include "gaussian_kernel.h"
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
-PostProcessor::PostProcessor(unsigned int width, unsigned int height) 
-    : width(width), height(height) {
+// Auto-exposure metering target (fragment path): small enough to reduce
+// cheaply, large enough to see small bright features. Power-of-two sizes
+// make every mip level an exact average of the one above.
+static const unsigned int METERING_WIDTH = 256;
+static const unsigned int METERING_HEIGHT = 128;
+static const int METERING_LEVELS = 9;       // 256x128 down to 1x1
+static const unsigned int HISTOGRAM_BINS = 256;
+
+// Fold value into seed (the boost::hash_combine mix)
+template <typename T>
+static void hashCombine(std::size_t& seed, const T& value) {
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+PostProcessor::PostProcessor(unsigned int width, unsigned int height, ShaderBuildMode mode) 
+    : width(width), height(height), computeBlurShaders{nullptr, nullptr, nullptr},
+      bloomMode(BloomMode::PingPong), bloomSource(BloomSource::BrightBuffer), bloomScale(1), bloomMipCount(MAX_BLOOM_MIPS),
+      kernelRadius(0), kernelPhases{-1, -1}, historyTarget(nullptr), historyValid(false), temporalWeight(0.2f),
+      historyThreshold(0.0f), historyRadius(0.0f), historySource(BloomSource::BrightBuffer), temporalFrame(0),
+      staticScene(false), sceneValid(false), sceneHashSet(false), sceneHash(0), bloomHash(0), bloomStaticFrames(0),
+      bloomCacheValid(false), bloomCached(false), bloomCache(nullptr),
+      histogramShader(nullptr), exposureComputeShader(nullptr), exposureCurrent(0), lastExposureTime(0.0),
+      exposureAdaptedTime(0.0), exposureSettled(true) {
     
-    // Load shaders
+    // Load shaders. Every pass is a separable fragment stage combined with one
+    // shared quad vertex stage in a program pipeline, so quad.vert is only
+    // compiled once however long the post chain gets.
     try {
-        extractShader = new Shader("shaders/quad.vert", "shaders/bloom_extract.frag");
-        blurShader = new Shader("shaders/quad.vert", "shaders/blur.frag");
-        finalShader = new Shader("shaders/quad.vert", "shaders/bloom_final.frag");
-        std::cout << "Successfully loaded post-processing shaders for bloom effect" << std::endl;
+        quadStage = Shader::variant(GL_VERTEX_SHADER, EmbeddedShaders::quad_vert, {}, mode);
+        extractShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::bloom_extract_frag, {}, mode);
+        // One branch-free program per blur direction, owned by the variant cache
+        blurShaders[0] = Shader::variant(GL_FRAGMENT_SHADER, EmbeddedShaders::blur_frag, {{"HORIZONTAL", "1"}}, mode);
+        blurShaders[1] = Shader::variant(GL_FRAGMENT_SHADER, EmbeddedShaders::blur_frag, {}, mode);
+        finalShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::bloom_final_frag, {}, mode);
+        downsampleShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::bloom_downsample_frag, {}, mode);
+        upsampleShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::bloom_upsample_frag, {}, mode);
+        luminanceLogShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::luminance_log_frag, {}, mode);
+        exposureAdaptShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::exposure_adapt_frag, {}, mode);
+        pipeline = new ProgramPipeline();
+        
+        // Compute bloom needs compute shaders and image stores (GL 4.3); the
+        // macOS 4.1 context only gets the fragment paths
+        if (supportsBloomMode(BloomMode::Compute)) {
+            computeBlurShaders[0] = Shader::variant(GL_COMPUTE_SHADER, EmbeddedShaders::bloom_blur_comp,
+                                                    {{"HORIZONTAL", "1"}, {"THRESHOLD", "1"}}, mode);
+            computeBlurShaders[1] = Shader::variant(GL_COMPUTE_SHADER, EmbeddedShaders::bloom_blur_comp,
+                                                    {{"HORIZONTAL", "1"}}, mode);
+            computeBlurShaders[2] = Shader::variant(GL_COMPUTE_SHADER, EmbeddedShaders::bloom_blur_comp, {}, mode);
+            bloomMode = BloomMode::Compute;
+            
+            // The histogram also needs shader storage buffers
+            if (GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object) {
+                histogramShader = new Shader(GL_COMPUTE_SHADER, EmbeddedShaders::luminance_histogram_comp, {}, mode);
+                exposureComputeShader = new Shader(GL_COMPUTE_SHADER, EmbeddedShaders::exposure_adapt_comp, {}, mode);
+            }
+        }
+        std::cout << (mode == ShaderBuildMode::Async ? "Submitted" : "Successfully loaded")
+                  << " post-processing shaders for bloom effect" << std::endl;
     } catch(const std::exception& e) {
         std::cerr << "Failed to load post-processing shaders: " << e.what() << std::endl;
         throw;
     }
     
-    // Initialize framebuffers and quad
-    initFramebuffers();
+    bloomTimer = new GpuTimer();
+    grading = new ColorGrading();
+    kernelBlock = new UniformBlock<BlurKernelConstants>(BLUR_KERNEL_BLOCK_BINDING);
+    
+    // Initialize render targets and quad
+    targets = new RenderTargetPool();
+    sceneTarget = brightTarget = depthTarget = nullptr;
+    glGenFramebuffers(1, &hdrFBO);
+    attachSceneTargets();
     initQuad();
+    initExposure();
+    initUniforms();
 }
 
 PostProcessor::~PostProcessor() {
     // Clean up resources
     delete extractShader;
-    delete blurShader;
     delete finalShader;
+    delete downsampleShader;
+    delete upsampleShader;
+    delete luminanceLogShader;
+    delete exposureAdaptShader;
+    delete histogramShader;
+    delete exposureComputeShader;
+    delete pipeline;
+    delete bloomTimer;
+    delete grading;
+    delete kernelBlock;
     
+    // The pool deletes every texture it handed out, depth included
     glDeleteFramebuffers(1, &hdrFBO);
-    glDeleteTextures(2, colorBuffers);
-    glDeleteFramebuffers(2, pingpongFBO);
-    glDeleteTextures(2, pingpongBuffers);
+    delete targets;
     glDeleteVertexArrays(1, &quadVAO);
+    glDeleteTextures(1, &emptyHudTexture);
+    
+    glDeleteTextures(2, exposureTextures);
+    glDeleteFramebuffers(2, exposureFBOs);
+    glDeleteTextures(1, &neutralExposureTexture);
+    glDeleteTextures(1, &meteringTexture);
+    glDeleteFramebuffers(1, &meteringFBO);
+    if (histogramShader) glDeleteBuffers(1, &histogramBuffer);
 }
 
 void PostProcessor::resize(unsigned int newWidth, unsigned int newHeight) {
-    // If the screen dimensions change, we need to recreate our framebuffers
+    GL_SCOPE("PostProcessor::resize");
     width = newWidth;
     height = newHeight;
     
-    // Clean up and reinitialize
-    glDeleteFramebuffers(1, &hdrFBO);
-    glDeleteTextures(2, colorBuffers);
-    glDeleteFramebuffers(2, pingpongFBO);
-    glDeleteTextures(2, pingpongBuffers);
-    
-    initFramebuffers();
+    // The bloom targets pick up the new size the next time a graph is built
+    attachSceneTargets();
 }
 
 void PostProcessor::beginRender() {
+    GL_SCOPE("PostProcessor::beginRender");
     // Bind the HDR framebuffer for scene rendering
     glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Whatever the clear color, nothing glows where nothing was drawn
+    const GLfloat black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    glClearBufferfv(GL_COLOR, 1, black);
 }
 
 void PostProcessor::endRender() {
@@ -58,96 +139,681 @@ void PostProcessor::endRender() {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void PostProcessor::applyBloom(float threshold, float intensity, int blur_passes) {
-    // 1. Extract bright parts of the scene
-    glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[0]);
-    glClear(GL_COLOR_BUFFER_BIT);
+bool PostProcessor::isReady() {
+    // Poll every program so all of them get finalized as soon as they can be
+    bool quadReady = quadStage->isReady();
+    bool extractReady = extractShader->isReady();
+    bool blurReady = blurShaders[0]->isReady();
+    blurReady = blurShaders[1]->isReady() && blurReady;
+    bool finalReady = finalShader->isReady();
+    bool mipReady = downsampleShader->isReady();
+    mipReady = upsampleShader->isReady() && mipReady;
+    bool computeReady = true;
+    for (Shader* shader : computeBlurShaders) {
+        if (shader) computeReady = shader->isReady() && computeReady;
+    }
+    bool exposureReady = luminanceLogShader->isReady();
+    exposureReady = exposureAdaptShader->isReady() && exposureReady;
+    if (histogramShader) exposureReady = histogramShader->isReady() && exposureReady;
+    if (exposureComputeShader) exposureReady = exposureComputeShader->isReady() && exposureReady;
+    return quadReady && extractReady && blurReady && finalReady && mipReady && computeReady && exposureReady;
+}
+
+void PostProcessor::watchShaders(ShaderWatcher& watcher) {
+    watcher.watch(quadStage);
+    watcher.watch(extractShader);
+    watcher.watch(blurShaders[0]);
+    watcher.watch(blurShaders[1]);
+    watcher.watch(finalShader);
+    watcher.watch(downsampleShader);
+    watcher.watch(upsampleShader);
+    for (Shader* shader : computeBlurShaders) {
+        if (shader) watcher.watch(shader);
+    }
+    watcher.watch(luminanceLogShader);
+    watcher.watch(exposureAdaptShader);
+    if (histogramShader) watcher.watch(histogramShader);
+    if (exposureComputeShader) watcher.watch(exposureComputeShader);
+}
+
+bool PostProcessor::supportsBloomMode(BloomMode mode) const {
+    if (mode == BloomMode::Compute) {
+        return GLEW_VERSION_4_3 || (GLEW_ARB_compute_shader && GLEW_ARB_shader_image_load_store);
+    }
+    return true;
+}
+
+bool PostProcessor::setBloomMode(BloomMode mode) {
+    if (!supportsBloomMode(mode)) {
+        return false;
+    }
+    if (mode != bloomMode) {
+        // The history is only kept while Temporal runs
+        if (bloomMode == BloomMode::Temporal) {
+            targets->release(historyTarget);
+            historyTarget = nullptr;
+        }
+        bloomMode = mode;
+        // Keep the averages of the modes apart
+        bloomTimer->reset();
+    }
+    return true;
+}
+
+void PostProcessor::setTemporalWeight(float weight) {
+    temporalWeight = weight < 0.01f ? 0.01f : (weight > 1.0f ? 1.0f : weight);
+}
+
+void PostProcessor::setExposure(const ExposureSettings& settings) {
+    // Turning it on snaps to the scene's luminance instead of easing in from
+    // wherever it was left
+    if (settings.enabled && !exposure.enabled) {
+        lastExposureTime = 0.0;
+    }
+    // Switching it either way changes every threshold at once; any other
+    // change sets the exposure moving until it settles again
+    if (settings.enabled != exposure.enabled) {
+        invalidateCache();
+    }
+    exposure = settings;
+    if (exposure.enabled) {
+        disturbExposure();
+    } else {
+        exposureSettled = true;
+    }
+}
+
+GLuint PostProcessor::getExposureTexture() const {
+    return exposure.enabled ? exposureTextures[exposureCurrent] : neutralExposureTexture;
+}
+
+void PostProcessor::setBloomMipCount(int count) {
+    bloomMipCount = count < 1 ? 1 : (count > MAX_BLOOM_MIPS ? MAX_BLOOM_MIPS : count);
+}
+
+void PostProcessor::setTargetFormats(const PostTargetFormats& formats) {
+    targetFormats = formats;
+    attachSceneTargets();
+}
+
+void PostProcessor::setBloomScale(int scale) {
+    bloomScale = scale < 1 ? 1 : (scale > 3 ? 3 : scale);
+}
+
+unsigned int PostProcessor::mipWidth(int level) const {
+    unsigned int size = width >> (level + bloomScale);
+    return size > 0 ? size : 1;
+}
+
+unsigned int PostProcessor::mipHeight(int level) const {
+    unsigned int size = height >> (level + bloomScale);
+    return size > 0 ? size : 1;
+}
+
+bool PostProcessor::beginFrame(std::size_t hash) {
+    // A different scene meters differently
+    if (hash != sceneHash) {
+        disturbExposure();
+    }
+    bool unchanged = hash == sceneHash && exposureSettled;
+    sceneHash = hash;
+    sceneHashSet = true;
+    if (!staticScene) {
+        return true;
+    }
     
-    extractShader->use();
-    extractShader->setInt("scene", 0);
-    extractShader->setFloat("threshold", threshold);
+    // Whatever is drawn now stays valid, since static targets aren't discarded
+    bool draw = !(sceneValid && unchanged);
+    sceneValid = true;
+    return draw;
+}
+
+void PostProcessor::setStaticScene(bool enabled) {
+    // The last frame discarded its targets, or the next one will
+    staticScene = enabled;
+    sceneValid = false;
+}
+
+void PostProcessor::invalidateCache() {
+    sceneValid = false;
+    bloomStaticFrames = 0;
+    bloomCacheValid = false;
+}
+
+PostProcessor::SceneTargets PostProcessor::importSceneTargets(FrameGraph& graph) {
+    // Unless the scene is static every frame redraws all three, so nothing
+    // needs to survive the frame
+    bool discardable = !staticScene;
+    SceneTargets scene;
+    scene.color = graph.importTarget("scene.color", sceneTarget->texture, sceneTarget->desc,
+                                     hdrFBO, GL_COLOR_ATTACHMENT0, discardable);
+    scene.bright = graph.importTarget("scene.bright", brightTarget->texture, brightTarget->desc,
+                                      hdrFBO, GL_COLOR_ATTACHMENT1, discardable);
+    scene.depth = graph.importTarget("scene.depth", depthTarget->texture, depthTarget->desc,
+                                     hdrFBO, GL_DEPTH_ATTACHMENT, discardable);
+    return scene;
+}
+
+void PostProcessor::applyBloom(float threshold, float intensity, float radius) {
+    FrameGraph graph(*targets);
+    addBloomPasses(graph, importSceneTargets(graph), threshold, intensity, radius);
+    graph.execute();
     
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[1]); // Use the bright buffer from the HDR FBO
+    // Back to the state the rest of the frame (text overlay) expects; the
+    // composite leaves the backbuffer's depth alone
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+FrameResource PostProcessor::createHudLayer(FrameGraph& graph) {
+    return graph.createTarget("hud", {width, height, GL_RGBA8, 1});
+}
+
+void PostProcessor::addBloomPasses(FrameGraph& graph, const SceneTargets& scene,
+                                   float threshold, float intensity, float radius, FrameResource hud) {
+    FrameResource backbuffer = graph.importBackbuffer(width, height);
     
-    renderQuad();
+    if (!isReady()) {
+        // Programs are still compiling: show the raw scene rather than stall
+        graph.addPass("scene blit", [this](const FrameGraph::Context&) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, hdrFBO);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }).read(scene.color).write(backbuffer);
+        return;
+    }
     
-    // 2. Apply gaussian blur (ping-pong between two framebuffers)
-    bool horizontal = true;
+    // Exposure adapts every frame, cached bloom or not
+    FrameResource exposureState = addExposurePasses(graph, scene);
     
-    blurShader->use();
-    blurShader->setInt("image", 0);
+    // Inputs that repeat last frame's give the same bloom. Only frames that
+    // called beginFrame can tell.
+    std::size_t hash = hashBloomInputs(threshold, radius);
+    // The thresholds follow the exposure, so a frame only repeats the last
+    // once it has settled
+    bloomStaticFrames = sceneHashSet && hash == bloomHash && exposureSettled ? bloomStaticFrames + 1 : 0;
+    bloomHash = hash;
+    sceneHashSet = false;
+    if (bloomStaticFrames == 0 && bloomCacheValid) {
+        bloomCacheValid = false;
+        targets->release(bloomCache);
+        bloomCache = nullptr;
+    }
+    bloomCached = bloomCacheValid;
     
-    // Multiple blur passes for smoother results
-    for (int i = 0; i < blur_passes; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal ? 1 : 0]);
-        blurShader->setBool("horizontal", horizontal);
+    FrameResource bloom;
+    if (bloomCached) {
+        RenderTarget* cache = bloomMode == BloomMode::Temporal ? historyTarget : bloomCache;
+        bloom = graph.importTarget("bloom.cache", cache->texture, cache->desc, cache->fbo, GL_COLOR_ATTACHMENT0, false);
+    } else {
+        switch (bloomMode) {
+            case BloomMode::MipChain: bloom = addMipChainPasses(graph, scene, threshold, radius); break;
+            case BloomMode::Compute: bloom = addComputePasses(graph, scene, threshold, radius); break;
+            case BloomMode::Temporal: bloom = addTemporalPasses(graph, scene, threshold, radius); break;
+            default: bloom = addPingPongPasses(graph, scene, threshold, radius); break;
+        }
+        
+        if (bloomMode == BloomMode::Temporal) {
+            // The history is the cache once it has converged on the static
+            // input, to within about 1%
+            bloomCacheValid = bloomStaticFrames >= static_cast<int>(std::ceil(4.0f / temporalWeight));
+        } else if (bloomStaticFrames > 0) {
+            // Seen twice in a row, so likely to stay: keep a copy. Moving
+            // scenes never pay for the copy.
+            bloomCache = targets->reacquire(bloomCache, bloomDesc(0));
+            FrameResource cache = graph.importTarget("bloom.cache", bloomCache->texture, bloomCache->desc,
+                                                     bloomCache->fbo, GL_COLOR_ATTACHMENT0, false);
+            graph.addPass("bloom cache store", [this, bloom](const FrameGraph::Context& context) {
+                // Compute bloom was written with imageStore, which a blit only
+                // sees after a framebuffer barrier
+                if (bloomMode == BloomMode::Compute) {
+                    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+                }
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, context.framebuffer(bloom));
+                glReadBuffer(GL_COLOR_ATTACHMENT0);
+                glBlitFramebuffer(0, 0, mipWidth(0), mipHeight(0), 0, 0, mipWidth(0), mipHeight(0),
+                                  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }).read(bloom).write(cache);
+            bloom = cache;
+            bloomCacheValid = true;
+        }
+    }
+    
+    // Combine the original scene with the blurred bright parts (render to screen)
+    grading->update();
+    FrameGraph::PassBuilder composite = graph.addPass("composite",
+                                                      [this, scene, bloom, hud, exposureState, intensity](const FrameGraph::Context& context) {
+        // The quad covers the whole backbuffer with depth testing off, so
+        // there's nothing to clear first
+        bloomTimer->end();
+        
+        pipeline->use(*quadStage, *finalShader);
+        finalShader->set(finalBloomBlur, 1);
+        finalShader->set(finalBloomIntensity, intensity);
         
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, pingpongBuffers[horizontal ? 0 : 1]);
+        glBindTexture(GL_TEXTURE_2D, context.texture(scene.color));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, context.texture(bloom));
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, grading->texture());
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, hud != NO_FRAME_RESOURCE ? context.texture(hud) : emptyHudTexture);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, exposureState != NO_FRAME_RESOURCE ? context.texture(exposureState)
+                                                                        : neutralExposureTexture);
         
         renderQuad();
+    });
+    composite.read(scene.color).read(bloom).write(backbuffer);
+    if (hud != NO_FRAME_RESOURCE) {
+        composite.read(hud);
+    }
+    if (exposureState != NO_FRAME_RESOURCE) {
+        composite.read(exposureState);
+    }
+}
+
+std::size_t PostProcessor::hashBloomInputs(float threshold, float radius) const {
+    std::size_t seed = sceneHash;
+    hashCombine(seed, threshold);
+    hashCombine(seed, radius);
+    hashCombine(seed, static_cast<int>(bloomMode));
+    hashCombine(seed, static_cast<int>(bloomSource));
+    hashCombine(seed, bloomScale);
+    hashCombine(seed, bloomMipCount);
+    hashCombine(seed, temporalWeight);
+    hashCombine(seed, targetFormats.bloom);
+    hashCombine(seed, width);
+    hashCombine(seed, height);
+    return seed;
+}
+
+int PostProcessor::prepareKernel(float radius, int horizontalPhase, int verticalPhase) {
+    // Blurring twice with a Gaussian adds the variances, so n passes of
+    // radius r / sqrt(n) give the same glow as one pass of radius r
+    float ratio = radius / MAX_BLUR_RADIUS;
+    int pairs = ratio > 1.0f ? static_cast<int>(std::ceil(ratio * ratio)) : 1;
+    int passRadius = static_cast<int>(std::ceil(radius / std::sqrt(static_cast<float>(pairs))));
+    passRadius = passRadius < 1 ? 1 : (passRadius > MAX_BLUR_RADIUS ? MAX_BLUR_RADIUS : passRadius);
+    
+    if (passRadius != kernelRadius || horizontalPhase != kernelPhases[0] || verticalPhase != kernelPhases[1]) {
+        GaussianKernel kernel(passRadius);
+        auto tapsOf = [&](int phase) {
+            return phase < 0 ? kernel.bilinearTaps() : kernel.interleavedTaps(phase, TEMPORAL_PHASES);
+        };
+        std::vector<GaussianKernel::Tap> horizontal = tapsOf(horizontalPhase);
+        std::vector<GaussianKernel::Tap> vertical = tapsOf(verticalPhase);
         
-        horizontal = !horizontal;
+        BlurKernelConstants constants = {};
+        constants.radius = passRadius;
+        constants.tapCount = static_cast<int>(horizontal.size());
+        constants.verticalTapCount = static_cast<int>(vertical.size());
+        for (std::size_t i = 0; i < horizontal.size(); i++) {
+            constants.taps[i] = glm::vec4(horizontal[i].offset, horizontal[i].weight, 0.0f, 0.0f);
+        }
+        for (std::size_t i = 0; i < vertical.size(); i++) {
+            constants.verticalTaps[i] = glm::vec4(vertical[i].offset, vertical[i].weight, 0.0f, 0.0f);
+        }
+        const std::vector<float>& weights = kernel.weights();
+        for (std::size_t i = 0; i < weights.size(); i++) {
+            constants.weights[i / 4][i % 4] = weights[i];
+        }
+        kernelBlock->update(constants);
+        kernelRadius = passRadius;
+        kernelPhases[0] = horizontalPhase;
+        kernelPhases[1] = verticalPhase;
     }
+    return pairs;
+}
+
+RenderTargetDesc PostProcessor::bloomDesc(int level) const {
+    return {mipWidth(level), mipHeight(level), targetFormats.bloom, 1};
+}
+
+FrameResource PostProcessor::addSourcePass(FrameGraph& graph, const SceneTargets& scene, float threshold) {
+    FrameResource source = graph.createTarget("bloom.source", bloomDesc(0));
     
-    // 3. Combine the original scene with the blurred bright parts (render to screen)
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (bloomSource == BloomSource::BrightBuffer) {
+        // The scene pass already wrote thresholded light to attachment 1; a
+        // linear blit filters it down to the bloom resolution on the way
+        graph.addPass("bloom bright downsample", [this](const FrameGraph::Context&) {
+            bloomTimer->begin();
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, hdrFBO);
+            glReadBuffer(GL_COLOR_ATTACHMENT1);
+            glBlitFramebuffer(0, 0, width, height, 0, 0, mipWidth(0), mipHeight(0), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }).read(scene.bright).write(source);
+        return source;
+    }
+    
+    // Threshold the scene color straight into the bloom target; the bilinear
+    // fetch at reduced resolution doubles as the downsample
+    graph.addPass("bloom extract", [this, scene, threshold](const FrameGraph::Context& context) {
+        bloomTimer->begin();
+        pipeline->use(*quadStage, *extractShader);
+        extractShader->set(extractThreshold, threshold);
+        
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, context.texture(scene.color));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, getExposureTexture());
+        renderQuad();
+    }).read(scene.color).write(source);
+    return source;
+}
+
+FrameResource PostProcessor::addPingPongPasses(FrameGraph& graph, const SceneTargets& scene,
+                                               float threshold, float radius) {
+    // 1. Bright parts at bloom resolution
+    FrameResource image = addSourcePass(graph, scene, threshold);
+    
+    // 2. Apply gaussian blur. The kernel is in bloom-resolution texels. Each
+    // pass writes a new target; the graph folds them onto two textures.
+    int blur_passes = 2 * prepareKernel(radius / (1 << bloomScale));
+    for (int i = 0; i < blur_passes; i++) {
+        bool horizontal = i % 2 == 0;
+        std::string suffix = (horizontal ? "h" : "v") + std::to_string(i / 2);
+        FrameResource blurred = graph.createTarget("bloom.blur." + suffix, bloomDesc(0));
+        graph.addPass("bloom blur " + suffix, [this, image, horizontal](const FrameGraph::Context& context) {
+            pipeline->use(*quadStage, *blurShaders[horizontal ? 0 : 1]);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(image));
+            renderQuad();
+        }).read(image).write(blurred);
+        image = blurred;
+    }
+    return image;
+}
+
+FrameResource PostProcessor::addMipChainPasses(FrameGraph& graph, const SceneTargets& scene,
+                                               float threshold, float radius) {
+    // Each level doubles the reach of the tent filter, starting at one source
+    // texel (2 pixels at half resolution)
+    float texel = static_cast<float>(1 << bloomScale);
+    int depth = radius > 2.0f * texel ? static_cast<int>(std::ceil(std::log2(radius / texel))) : 1;
+    depth = depth > bloomMipCount ? bloomMipCount : depth;
     
-    finalShader->use();
-    finalShader->setInt("scene", 0);
-    finalShader->setInt("bloomBlur", 1);
-    finalShader->setFloat("bloomIntensity", intensity);
+    // 1. Bright parts into the first mip
+    FrameResource mips[MAX_BLOOM_MIPS];
+    mips[0] = addSourcePass(graph, scene, threshold);
     
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, pingpongBuffers[!horizontal ? 1 : 0]);
+    // 2. Walk down the chain, each level filtered from the one above
+    for (int level = 1; level < depth; level++) {
+        mips[level] = graph.createTarget("bloom.mip" + std::to_string(level), bloomDesc(level));
+        FrameResource above = mips[level - 1];
+        graph.addPass("bloom downsample " + std::to_string(level), [this, above](const FrameGraph::Context& context) {
+            pipeline->use(*quadStage, *downsampleShader);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(above));
+            renderQuad();
+        }).read(above).write(mips[level]);
+    }
     
-    renderQuad();
+    // 3. Walk back up, adding each smaller level onto the next larger one
+    for (int level = depth - 1; level > 0; level--) {
+        FrameResource below = mips[level];
+        graph.addPass("bloom upsample " + std::to_string(level), [this, below](const FrameGraph::Context& context) {
+            pipeline->use(*quadStage, *upsampleShader);
+            upsampleShader->set(upsampleRadius, 1.0f);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(below));
+            renderQuad();
+        }).read(below).write(mips[level - 1]).blend(GL_ONE, GL_ONE);
+    }
+    
+    return mips[0];
+}
+
+FrameResource PostProcessor::addComputePasses(FrameGraph& graph, const SceneTargets& scene,
+                                              float threshold, float radius) {
+    // The bright buffer only needs its blit; the extract threshold is fused
+    // into the first horizontal pass instead of running as its own pass
+    bool fusedExtract = bloomSource == BloomSource::Extract;
+    FrameResource image = fusedExtract ? scene.color : addSourcePass(graph, scene, threshold);
+    
+    // Must match TILE_SIZE in bloom_blur.comp
+    const unsigned int TILE_SIZE = 128;
+    unsigned int blurWidth = mipWidth(0);
+    unsigned int blurHeight = mipHeight(0);
+    unsigned int rowGroups = (blurWidth + TILE_SIZE - 1) / TILE_SIZE;
+    unsigned int columnGroups = (blurHeight + TILE_SIZE - 1) / TILE_SIZE;
+    
+    // Same pass structure as the ping-pong path, at bloom resolution
+    int pairs = prepareKernel(radius / (1 << bloomScale));
+    GLenum imageFormat = targetFormats.bloom;
+    for (int i = 0; i < pairs; i++) {
+        // Horizontal: bloom source (first pass) or the last vertical pass
+        bool fused = i == 0 && fusedExtract;
+        std::string pair = std::to_string(i);
+        FrameResource horizontal = graph.createTarget("bloom.compute.h" + pair, bloomDesc(0));
+        graph.addPass("bloom compute h" + pair, [=](const FrameGraph::Context& context) {
+            Shader* shader = computeBlurShaders[fused ? 0 : 1];
+            if (fused) bloomTimer->begin();
+            shader->use();
+            if (fused) {
+                shader->set(computeThreshold, threshold);
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, getExposureTexture());
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(image));
+            glBindImageTexture(0, context.texture(horizontal), 0, GL_FALSE, 0, GL_WRITE_ONLY, imageFormat);
+            glDispatchCompute(rowGroups, blurHeight, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }).read(image).write(horizontal).compute();
+        
+        FrameResource vertical = graph.createTarget("bloom.compute.v" + pair, bloomDesc(0));
+        graph.addPass("bloom compute v" + pair, [=](const FrameGraph::Context& context) {
+            computeBlurShaders[2]->use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(horizontal));
+            glBindImageTexture(0, context.texture(vertical), 0, GL_FALSE, 0, GL_WRITE_ONLY, imageFormat);
+            glDispatchCompute(blurWidth, columnGroups, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }).read(horizontal).write(vertical).compute();
+        image = vertical;
+    }
+    
+    return image;
+}
+
+FrameResource PostProcessor::addTemporalPasses(FrameGraph& graph, const SceneTargets& scene,
+                                               float threshold, float radius) {
+    // A new target (resize, bloom scale or format change) starts a new history,
+    // as do a different source and sudden threshold or radius jumps
+    RenderTarget* previous = historyTarget;
+    historyTarget = targets->reacquire(historyTarget, bloomDesc(0));
+    if (historyTarget != previous || bloomSource != historySource ||
+        std::fabs(threshold - historyThreshold) > 0.05f || std::fabs(radius - historyRadius) > 0.1f * historyRadius) {
+        historyValid = false;
+    }
+    historySource = bloomSource;
+    historyThreshold = threshold;
+    historyRadius = radius;
+    float weight = historyValid ? temporalWeight : 1.0f;
+    historyValid = true;
+    
+    // The history outlives the frame, so it must never be discarded
+    FrameResource history = graph.importTarget("bloom.history", historyTarget->texture, historyTarget->desc,
+                                               historyTarget->fbo, GL_COLOR_ATTACHMENT0, false);
+    
+    // 1. Bright parts at bloom resolution
+    FrameResource image = addSourcePass(graph, scene, threshold);
+    
+    // 2. The ping-pong blur with this frame's share of the taps. The
+    // horizontal and vertical phases step through every pair, so the frames
+    // average to the full 2-D kernel (one phase for both would not). The
+    // last pass blends straight into the history:
+    // history += weight * (blur - history).
+    unsigned long frame = temporalFrame++;
+    int horizontalPhase = static_cast<int>(frame % TEMPORAL_PHASES);
+    int verticalPhase = static_cast<int>((frame / TEMPORAL_PHASES + frame) % TEMPORAL_PHASES);
+    int blur_passes = 2 * prepareKernel(radius / (1 << bloomScale), horizontalPhase, verticalPhase);
+    for (int i = 0; i < blur_passes; i++) {
+        bool horizontal = i % 2 == 0;
+        bool last = i == blur_passes - 1;
+        std::string suffix = (horizontal ? "h" : "v") + std::to_string(i / 2);
+        FrameResource blurred = last ? history : graph.createTarget("bloom.blur." + suffix, bloomDesc(0));
+        FrameGraph::PassBuilder pass = graph.addPass("bloom blur " + suffix,
+                                                     [this, image, horizontal, last, weight](const FrameGraph::Context& context) {
+            if (last) glBlendColor(0.0f, 0.0f, 0.0f, weight);
+            pipeline->use(*quadStage, *blurShaders[horizontal ? 0 : 1]);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(image));
+            renderQuad();
+        });
+        pass.read(image).write(blurred);
+        if (last) pass.blend(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+        image = blurred;
+    }
+    return history;
+}
+
+FrameResource PostProcessor::addExposurePasses(FrameGraph& graph, const SceneTargets& scene) {
+    if (!exposure.enabled) {
+        return NO_FRAME_RESOURCE;
+    }
+    
+    // Ease by the time since the last frame, capped so a stall doesn't jump;
+    // the first frame snaps straight to the metered value
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    double elapsed = now - lastExposureTime;
+    float step = lastExposureTime == 0.0 ? 1.0f
+               : 1.0f - std::exp(-exposure.adaptationRate * static_cast<float>(elapsed < 0.1 ? elapsed : 0.1));
+    lastExposureTime = now;
+    
+    float minLog = exposure.minLogLuminance;
+    float maxLog = exposure.maxLogLuminance > minLog ? exposure.maxLogLuminance : minLog + 1.0f;
+    float key = exposure.key;
+    
+    // The adapted luminance and its target both lie in the metered range,
+    // so the gap is at most 2^(maxLog - minLog) times the adapted value;
+    // a snap closes it outright, and without a rate it never moves
+    if (step >= 1.0f || exposure.adaptationRate <= 0.0f) {
+        exposureSettled = true;
+    } else if (!exposureSettled) {
+        exposureAdaptedTime += elapsed < 0.1 ? elapsed : 0.1;
+        double settleTime = ((maxLog - minLog) * std::log(2.0) - std::log(EXPOSURE_TOLERANCE)) / exposure.adaptationRate;
+        exposureSettled = exposureAdaptedTime >= settleTime;
+    }
+    
+    int previous = exposureCurrent;
+    exposureCurrent = 1 - exposureCurrent;
+    int next = exposureCurrent;
+    RenderTargetDesc stateDesc = {1, 1, GL_RG32F, 1};
+    FrameResource previousState = graph.importTarget("exposure.previous", exposureTextures[previous], stateDesc,
+                                                     exposureFBOs[previous], GL_COLOR_ATTACHMENT0, false);
+    FrameResource state = graph.importTarget("exposure.state", exposureTextures[next], stateDesc,
+                                             exposureFBOs[next], GL_COLOR_ATTACHMENT0, false);
+    
+    if (histogramShader) {
+        // Histogram of the scene into the storage buffer; nothing in the graph
+        // reads the buffer, so the pass is kept as a side effect
+        unsigned int groupsX = ((width + 1) / 2 + 15) / 16;
+        unsigned int groupsY = ((height + 1) / 2 + 15) / 16;
+        graph.addPass("exposure histogram", [=](const FrameGraph::Context& context) {
+            histogramShader->use();
+            histogramShader->set(histogramMinLog, minLog);
+            histogramShader->set(histogramInverseRange, 1.0f / (maxLog - minLog));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, histogramBuffer);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(scene.color));
+            glDispatchCompute(groupsX, groupsY, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }).read(scene.color).compute().sideEffect();
+        
+        // Reduce it to the mean, adapt and clear it for the next frame
+        graph.addPass("exposure adapt", [=](const FrameGraph::Context& context) {
+            exposureComputeShader->use();
+            exposureComputeShader->set(computeAdaptMinLog, minLog);
+            exposureComputeShader->set(computeAdaptRange, maxLog - minLog);
+            exposureComputeShader->set(computeAdaptation, step);
+            exposureComputeShader->set(computeAdaptKey, key);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, histogramBuffer);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(previousState));
+            glBindImageTexture(0, context.texture(state), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        }).read(previousState).write(state).compute();
+        return state;
+    }
+    
+    // Log luminance into the metering target, averaged down its mipmaps
+    FrameResource metering = graph.importTarget("exposure.metering", meteringTexture,
+                                                {METERING_WIDTH, METERING_HEIGHT, GL_R16F, 1},
+                                                meteringFBO, GL_COLOR_ATTACHMENT0, true);
+    graph.addPass("exposure metering", [=](const FrameGraph::Context& context) {
+        pipeline->use(*quadStage, *luminanceLogShader);
+        luminanceLogShader->set(logMinLog, minLog);
+        luminanceLogShader->set(logMaxLog, maxLog);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, context.texture(scene.color));
+        renderQuad();
+        glBindTexture(GL_TEXTURE_2D, context.texture(metering));
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }).read(scene.color).write(metering);
+    
+    graph.addPass("exposure adapt", [=](const FrameGraph::Context& context) {
+        pipeline->use(*quadStage, *exposureAdaptShader);
+        exposureAdaptShader->set(adaptation, step);
+        exposureAdaptShader->set(adaptKey, key);
+        exposureAdaptShader->set(adaptMeanLevel, static_cast<float>(METERING_LEVELS - 1));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, context.texture(previousState));
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, context.texture(metering));
+        renderQuad();
+    }).read(previousState).read(metering).write(state);
+    return state;
+}
+
+void PostProcessor::disturbExposure() {
+    if (exposure.enabled) {
+        exposureSettled = false;
+        exposureAdaptedTime = 0.0;
+    }
 }
 
 void PostProcessor::renderToScreen() {
+    GL_SCOPE("PostProcessor::renderToScreen");
     // Render the scene texture directly to the screen
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    finalShader->use();
-    finalShader->setInt("scene", 0);
-    finalShader->setInt("bloomBlur", 0);
-    finalShader->setFloat("bloomIntensity", 0.0f); // No bloom
+    pipeline->use(*quadStage, *finalShader);
+    finalShader->set(finalBloomBlur, 0);
+    finalShader->set(finalBloomIntensity, 0.0f); // No bloom
     
+    grading->update();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
+    glBindTexture(GL_TEXTURE_2D, sceneTarget->texture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_3D, grading->texture());
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, emptyHudTexture);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, getExposureTexture());
     
     renderQuad();
 }
 
-void PostProcessor::initFramebuffers() {
-    // 1. Create HDR framebuffer with two color attachments
-    glGenFramebuffers(1, &hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+void PostProcessor::attachSceneTargets() {
+    GL_SCOPE("PostProcessor::attachSceneTargets");
+    // New targets hold nothing yet
+    sceneValid = false;
+    // One color target for the rendered scene and one for the bright parts,
+    // plus depth for scene rendering
+    sceneTarget = targets->reacquire(sceneTarget, {width, height, targetFormats.scene, 1});
+    brightTarget = targets->reacquire(brightTarget, {width, height, targetFormats.bright, 1});
+    depthTarget = targets->reacquire(depthTarget, {width, height, GL_DEPTH_COMPONENT24, 1});
     
-    // Create two color buffers: one for the rendered scene and one for the bright parts
-    glGenTextures(2, colorBuffers);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        // Attach texture to framebuffer
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffers[i], 0);
-    }
-    
-    // Create and attach a renderbuffer object for depth testing
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneTarget->texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, brightTarget->texture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->texture, 0);
     
     // Tell OpenGL which color attachments we'll use for rendering
     unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
@@ -158,26 +824,6 @@ void PostProcessor::initFramebuffers() {
         std::cerr << "Framebuffer not complete!" << std::endl;
     }
     
-    // 2. Create ping-pong framebuffers for blurring
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongBuffers);
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongBuffers[i], 0);
-        
-        // Check if framebuffer is complete
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-            std::cerr << "Ping-pong framebuffer " << i << " not complete!" << std::endl;
-        }
-    }
-    
-    // Unbind framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -209,6 +855,110 @@ void PostProcessor::initQuad() {
     glEnableVertexAttribArray(1);
     
     glBindVertexArray(0);
+    
+    // Stands in for the HUD layer when a frame has none
+    const unsigned char transparent[4] = {0, 0, 0, 0};
+    glGenTextures(1, &emptyHudTexture);
+    glBindTexture(GL_TEXTURE_2D, emptyHudTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, transparent);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void PostProcessor::initExposure() {
+    // The state starts at the key, so the exposure multiplier starts at 1
+    const float initial[2] = {exposure.key, 1.0f};
+    unsigned int* textures[3] = {&exposureTextures[0], &exposureTextures[1], &neutralExposureTexture};
+    for (unsigned int* texture : textures) {
+        glGenTextures(1, texture);
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, 1, 1, 0, GL_RG, GL_FLOAT, initial);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glGenFramebuffers(2, exposureFBOs);
+    for (int i = 0; i < 2; i++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, exposureFBOs[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, exposureTextures[i], 0);
+    }
+    
+    // Metering target for the fragment path, mipmapped down to 1x1
+    glGenTextures(1, &meteringTexture);
+    glBindTexture(GL_TEXTURE_2D, meteringTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, METERING_WIDTH, METERING_HEIGHT, 0, GL_RED, GL_FLOAT, NULL);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &meteringFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, meteringFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, meteringTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    // Histogram bins, cleared by the adapt pass after each use
+    if (histogramShader) {
+        std::vector<GLuint> zeros(HISTOGRAM_BINS, 0);
+        glGenBuffers(1, &histogramBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, histogramBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, HISTOGRAM_BINS * sizeof(GLuint), zeros.data(), GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+void PostProcessor::initUniforms() {
+    extractThreshold = extractShader->uniform<float>("threshold");
+    finalBloomIntensity = finalShader->uniform<float>("bloomIntensity");
+    finalBloomBlur = finalShader->uniform<int>("bloomBlur");
+    upsampleRadius = upsampleShader->uniform<float>("filterRadius");
+    if (computeBlurShaders[0]) {
+        computeThreshold = computeBlurShaders[0]->uniform<float>("threshold");
+    }
+    logMinLog = luminanceLogShader->uniform<float>("minLogLuminance");
+    logMaxLog = luminanceLogShader->uniform<float>("maxLogLuminance");
+    adaptation = exposureAdaptShader->uniform<float>("adaptation");
+    adaptKey = exposureAdaptShader->uniform<float>("key");
+    adaptMeanLevel = exposureAdaptShader->uniform<float>("meanLevel");
+    if (histogramShader) {
+        histogramMinLog = histogramShader->uniform<float>("minLogLuminance");
+        histogramInverseRange = histogramShader->uniform<float>("inverseLogLuminanceRange");
+        computeAdaptMinLog = exposureComputeShader->uniform<float>("minLogLuminance");
+        computeAdaptRange = exposureComputeShader->uniform<float>("logLuminanceRange");
+        computeAdaptation = exposureComputeShader->uniform<float>("adaptation");
+        computeAdaptKey = exposureComputeShader->uniform<float>("key");
+    }
+    
+    // Sampler units never change, so set them once per link instead of every frame
+    extractShader->onLinked([](Shader& shader) {
+        shader.setInt("scene", 0);
+        shader.setInt("exposureState", 1);
+    });
+    blurShaders[0]->onLinked([](Shader& shader) { shader.setInt("image", 0); });
+    blurShaders[1]->onLinked([](Shader& shader) { shader.setInt("image", 0); });
+    downsampleShader->onLinked([](Shader& shader) { shader.setInt("source", 0); });
+    upsampleShader->onLinked([](Shader& shader) { shader.setInt("source", 0); });
+    for (Shader* shader : computeBlurShaders) {
+        if (shader) shader->onLinked([](Shader& shader) {
+            shader.setInt("source", 0);
+            shader.setInt("exposureState", 1);
+        });
+    }
+    luminanceLogShader->onLinked([](Shader& shader) { shader.setInt("scene", 0); });
+    exposureAdaptShader->onLinked([](Shader& shader) {
+        shader.setInt("previousState", 0);
+        shader.setInt("logLuminance", 1);
+    });
+    if (histogramShader) {
+        histogramShader->onLinked([](Shader& shader) { shader.setInt("scene", 0); });
+        exposureComputeShader->onLinked([](Shader& shader) { shader.setInt("previousState", 0); });
+    }
+    finalShader->onLinked([](Shader& shader) {
+        shader.setInt("scene", 0);
+        shader.setInt("gradingLut", 2);
+        shader.setInt("hudLayer", 3);
+        shader.setInt("exposureState", 4);
+    });
+    glUseProgram(0);
 }
 
 void PostProcessor::renderQuad() {
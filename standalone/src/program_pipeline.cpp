@@ -0,0 +1,26 @@
+#include "program_pipeline.h"
+#include "gl_debug.h"
+
+ProgramPipeline::ProgramPipeline() : ID(0), vertexProgram(0), fragmentProgram(0) {
+    glGenProgramPipelines(1, &ID);
+}
+
+ProgramPipeline::~ProgramPipeline() {
+    glDeleteProgramPipelines(1, &ID);
+}
+
+void ProgramPipeline::use(const Shader& vertex, const Shader& fragment) {
+    if (vertex.ID != vertexProgram) {
+        glUseProgramStages(ID, GL_VERTEX_SHADER_BIT, vertex.ID);
+        vertexProgram = vertex.ID;
+    }
+    if (fragment.ID != fragmentProgram) {
+        glUseProgramStages(ID, GL_FRAGMENT_SHADER_BIT, fragment.ID);
+        fragmentProgram = fragment.ID;
+    }
+
+    // A current program takes precedence over the bound pipeline
+    glUseProgram(0);
+    glBindProgramPipeline(ID);
+    GL_CHECK("binding program pipeline");
+}
@@ -0,0 +1,135 @@
+#include "render_target_pool.h"
+#include "gl_debug.h"
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+
+bool RenderTargetDesc::operator<(const RenderTargetDesc& other) const {
+    return std::tie(width, height, format, samples) <
+           std::tie(other.width, other.height, other.format, other.samples);
+}
+
+bool RenderTargetDesc::operator==(const RenderTargetDesc& other) const {
+    return width == other.width && height == other.height && format == other.format && samples == other.samples;
+}
+
+static bool isDepthFormat(GLenum format) {
+    switch (format) {
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32F:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH32F_STENCIL8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+RenderTargetPool::~RenderTargetPool() {
+    for (RenderTarget* target : owned) {
+        destroy(target);
+    }
+}
+
+RenderTarget* RenderTargetPool::acquire(const RenderTargetDesc& desc) {
+    auto match = available.find(desc);
+    if (match != available.end()) {
+        RenderTarget* target = match->second;
+        available.erase(match);
+        return target;
+    }
+
+    RenderTarget* target = create(desc);
+    owned.push_back(target);
+    bytes += sizeOf(desc);
+    return target;
+}
+
+void RenderTargetPool::release(RenderTarget* target) {
+    if (!target) {
+        return;
+    }
+    target->lastUsed = frame;
+    available.emplace(target->desc, target);
+}
+
+RenderTarget* RenderTargetPool::reacquire(RenderTarget* target, const RenderTargetDesc& desc) {
+    if (target && target->desc == desc) {
+        return target;
+    }
+    release(target);
+    return acquire(desc);
+}
+
+void RenderTargetPool::endFrame() {
+    frame++;
+    for (auto it = available.begin(); it != available.end();) {
+        RenderTarget* target = it->second;
+        if (frame - target->lastUsed <= MAX_IDLE_FRAMES) {
+            ++it;
+            continue;
+        }
+        bytes -= sizeOf(target->desc);
+        owned.erase(std::find(owned.begin(), owned.end(), target));
+        destroy(target);
+        it = available.erase(it);
+    }
+}
+
+RenderTarget* RenderTargetPool::create(const RenderTargetDesc& desc) {
+    GL_SCOPE("RenderTargetPool::create");
+    RenderTarget* target = new RenderTarget{desc, 0, 0, 0};
+    bool depth = isDepthFormat(desc.format);
+    GLenum textureType = desc.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+    glGenTextures(1, &target->texture);
+    glBindTexture(textureType, target->texture);
+    if (desc.samples > 1) {
+        glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc.samples, desc.format, desc.width, desc.height, GL_TRUE);
+    } else {
+        // No data is uploaded, but the client format still has to be compatible
+        GLenum format = desc.format == GL_DEPTH24_STENCIL8 || desc.format == GL_DEPTH32F_STENCIL8 ? GL_DEPTH_STENCIL
+                      : depth ? GL_DEPTH_COMPONENT : GL_RGBA;
+        GLenum type = desc.format == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8
+                    : desc.format == GL_DEPTH32F_STENCIL8 ? GL_FLOAT_32_UNSIGNED_INT_24_8_REV : GL_FLOAT;
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.format, desc.width, desc.height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    if (!depth) {
+        glGenFramebuffers(1, &target->fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureType, target->texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Render target framebuffer (" << desc.width << "x" << desc.height
+                      << ") not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    return target;
+}
+
+void RenderTargetPool::destroy(RenderTarget* target) {
+    if (target->fbo) {
+        glDeleteFramebuffers(1, &target->fbo);
+    }
+    glDeleteTextures(1, &target->texture);
+    delete target;
+}
+
+std::size_t RenderTargetPool::sizeOf(const RenderTargetDesc& desc) {
+    std::size_t bytesPerPixel;
+    switch (desc.format) {
+        case GL_RGBA32F: bytesPerPixel = 16; break;
+        case GL_RGBA16F: bytesPerPixel = 8; break;
+        case GL_DEPTH32F_STENCIL8: bytesPerPixel = 8; break;
+        case GL_DEPTH_COMPONENT16: bytesPerPixel = 2; break;
+        default: bytesPerPixel = 4; break;   // RGBA8, R11F_G11F_B10F, 24/32-bit depth
+    }
+    return bytesPerPixel * desc.width * desc.height * (desc.samples > 1 ? desc.samples : 1);
+}
@@ -1,142 +1,742 @@
 #include "shader.h"
+#include "shader_compile_worker.h"
+#include "gl_debug.h"
+#include "uniform_buffer.h"
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath) {
-    // Print current working directory and check if files exist
-    std::cout << "Current working directory: " << std::filesystem::current_path() << std::endl;
-    std::cout << "Checking if vertex shader exists: " << std::filesystem::exists(vertexPath) << std::endl;
-    std::cout << "Checking if fragment shader exists: " << std::filesystem::exists(fragmentPath) << std::endl;
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+
+static const char* stageLabel(GLenum type) {
+    switch (type) {
+        case GL_VERTEX_SHADER: return "VERTEX";
+        case GL_FRAGMENT_SHADER: return "FRAGMENT";
+        case GL_COMPUTE_SHADER: return "COMPUTE";
+        default: return "STAGE";
+    }
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, ShaderBuildMode mode)
+    : Shader(vertexPath, fragmentPath, ShaderDefines(), mode) {}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines, ShaderBuildMode mode)
+    : ID(0), defines(defines) {
+    // Remember where the stages came from so the program can be reloaded
+    sourceFiles = {
+        {GL_VERTEX_SHADER, vertexPath, false},
+        {GL_FRAGMENT_SHADER, fragmentPath, false}
+    };
+    
+    build(loadStages(), mode);
+}
+
+Shader::Shader(GLenum stageType, const char* path, const ShaderDefines& defines, ShaderBuildMode mode)
+    : ID(0), defines(defines), separable(stageType != GL_COMPUTE_SHADER) {
+    sourceFiles = {{stageType, path, false}};
     
-    // 1. Retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+    build(loadStages(), mode);
+}
+
+Shader::Shader(const EmbeddedShader& vertex, const EmbeddedShader& fragment, const ShaderDefines& defines,
+               ShaderBuildMode mode)
+    : ID(0), defines(defines) {
+    sourceFiles = {
+        {GL_VERTEX_SHADER, std::string(vertex.name), true},
+        {GL_FRAGMENT_SHADER, std::string(fragment.name), true}
+    };
     
-    // Ensure ifstream objects can throw exceptions
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    build(loadStages(), mode);
+}
+
+Shader::Shader(GLenum stageType, const EmbeddedShader& stage, const ShaderDefines& defines, ShaderBuildMode mode)
+    : ID(0), defines(defines), separable(stageType != GL_COMPUTE_SHADER) {
+    sourceFiles = {{stageType, std::string(stage.name), true}};
     
+    build(loadStages(), mode);
+}
+
+std::map<std::string, Shader*> Shader::variants;
+
+Shader* Shader::variant(const EmbeddedShader& vertex, const EmbeddedShader& fragment, const ShaderDefines& defines,
+                        ShaderBuildMode mode) {
+    std::string key = variantKey(std::string(vertex.name) + "|" + std::string(fragment.name), defines);
+    auto it = variants.find(key);
+    if (it != variants.end()) {
+        return it->second;
+    }
+    
+    Shader* shader = new Shader(vertex, fragment, defines, mode);
+    variants[key] = shader;
+    return shader;
+}
+
+Shader* Shader::variant(GLenum stageType, const EmbeddedShader& stage, const ShaderDefines& defines,
+                        ShaderBuildMode mode) {
+    std::string key = variantKey("separable " + std::to_string(stageType) + "|" + std::string(stage.name), defines);
+    auto it = variants.find(key);
+    if (it != variants.end()) {
+        return it->second;
+    }
+    
+    Shader* shader = new Shader(stageType, stage, defines, mode);
+    variants[key] = shader;
+    return shader;
+}
+
+std::string Shader::variantKey(const std::string& sources, const ShaderDefines& defines) {
+    std::string key = sources;
+    for (const auto& define : defines) {
+        key += "|" + define.first + "=" + define.second;
+    }
+    return key;
+}
+
+void Shader::releaseVariants() {
+    for (auto& entry : variants) {
+        delete entry.second;
+    }
+    variants.clear();
+}
+
+Shader* Shader::fromSource(const char* vertexSource, const char* fragmentSource, ShaderBuildMode mode) {
+    Shader* shader = new Shader();
     try {
-        // Open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        
-        // Read file's buffer contents into streams
-        std::stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+        shader->build({
+            {GL_VERTEX_SHADER, "VERTEX", vertexSource},
+            {GL_FRAGMENT_SHADER, "FRAGMENT", fragmentSource}
+        }, mode);
+    } catch (...) {
+        delete shader;
+        throw;
+    }
+    return shader;
+}
+
+Shader::~Shader() {
+    if (pending) discardBuild(*pending);
+    if (reloadPending) discardBuild(*reloadPending);
+    if (ID != 0) {
+        glDeleteProgram(ID);
+    }
+}
+
+std::vector<Shader::StageSource> Shader::loadStages() {
+    std::vector<StageSource> stages;
+    std::vector<std::string> files;
+    for (const SourceFile& file : sourceFiles) {
+        ShaderPreprocessor::Result result;
+        try {
+            // Embedded sources (or their override files) resolve includes among
+            // themselves; plain paths read from disk
+            result = ShaderPreprocessor::process(file.path, defines,
+                file.embedded ? ShaderSources::load : ShaderSources::readFile);
+        } catch (const std::exception& e) {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+            throw;
+        }
         
-        // Close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
+        // Compiler messages name files by source string number, so spell
+        // out the mapping in the label when includes are involved
+        std::string label = stageLabel(file.type);
+        if (result.files.size() > 1) {
+            label += " (";
+            for (size_t i = 0; i < result.files.size(); i++) {
+                label += (i > 0 ? ", " : "") + std::to_string(i) + ": " + result.files[i];
+            }
+            label += ")";
+        }
         
-        // Convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        std::cout << "Loaded " << stageLabel(file.type) << " shader: " << file.path << " (" << result.source.length()
+                  << " bytes, " << result.files.size() << " files, " << defines.size() << " defines)" << std::endl;
         
-        std::cout << "Successfully loaded shader files:" << std::endl;
-        std::cout << "Vertex shader: " << vertexPath << std::endl;
-        std::cout << "Fragment shader: " << fragmentPath << std::endl;
-        std::cout << "Vertex shader code length: " << vertexCode.length() << std::endl;
-        std::cout << "Fragment shader code length: " << fragmentCode.length() << std::endl;
-    } catch(std::ifstream::failure& e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-        std::cerr << "Vertex path: " << vertexPath << std::endl;
-        std::cerr << "Fragment path: " << fragmentPath << std::endl;
-        throw;
+        files.insert(files.end(), result.files.begin(), result.files.end());
+        stages.push_back({file.type, label, result.source});
     }
     
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    includedFiles = files;
+    return stages;
+}
+
+bool Shader::parallelCompile = false;
+
+bool Shader::initParallelCompile() {
+    // Let the driver use as many compiler threads as it likes
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        parallelCompile = true;
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallelCompile = true;
+    }
+    std::cout << "Driver parallel shader compile: " << (parallelCompile ? "available" : "not available") << std::endl;
+    return parallelCompile;
+}
+
+void Shader::build(const std::vector<StageSource>& stages, ShaderBuildMode mode) {
+    GL_SCOPE("Shader::build");
+    auto start = std::chrono::steady_clock::now();
     
-    // 2. Compile shaders
-    unsigned int vertex, fragment;
+    // 1. Try the on-disk binary cache first
+    uint64_t key = programKey(stages);
+    unsigned int cached = loadCachedBinary(key);
+    if (cached != 0) {
+        ID = cached;
+        completeBuild(true, start);
+        return;
+    }
+    
+    // 2. Submit the compile; async builds return here and finish in isReady()
+    pending = submitBuild(stages, key, start, mode == ShaderBuildMode::Async);
+    if (pending->workerDone || (mode == ShaderBuildMode::Async && parallelCompile)) {
+        state = BuildState::Compiling;
+        return;
+    }
+    
+    finishBuild();
+}
+
+std::shared_ptr<Shader::PendingBuild> Shader::submitBuild(const std::vector<StageSource>& stages, uint64_t key,
+                                                          std::chrono::steady_clock::time_point start, bool async) const {
+    auto build = std::make_shared<PendingBuild>();
+    build->key = key;
+    build->start = start;
+    for (const StageSource& stage : stages) {
+        build->labels.push_back(stage.label);
+    }
+    bool retrievable = !programCacheDirectory.empty();
+    bool separable = this->separable;
     
-    // Vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    checkGLError("vertex shader compilation");
+    // No driver-side parallelism: hand the compile to the worker context
+    if (async && !parallelCompile && ShaderCompileWorker::running()) {
+        build->workerDone = ShaderCompileWorker::submit([build, stages, retrievable, separable]() {
+            submitStages(stages, retrievable, separable, *build);
+        });
+        return build;
+    }
     
-    // Fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    checkGLError("fragment shader compilation");
+    // Issue the compile; with parallel compile the driver works in the background
+    submitStages(stages, retrievable, separable, *build);
+    return build;
+}
+
+void Shader::submitStages(const std::vector<StageSource>& stages, bool retrievable, bool separable,
+                          PendingBuild& target) {
+    // Only issue commands here - querying any status would block until the
+    // compile is done and defeat parallel compilation
+    for (const StageSource& stage : stages) {
+        const char* code = stage.source.c_str();
+        unsigned int shader = glCreateShader(stage.type);
+        glShaderSource(shader, 1, &code, NULL);
+        glCompileShader(shader);
+        target.shaders.push_back(shader);
+    }
     
-    // Shader program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
-    checkGLError("shader program linking");
+    target.program = glCreateProgram();
+    for (unsigned int shader : target.shaders) {
+        glAttachShader(target.program, shader);
+    }
+    // Single-stage programs that get combined in a ProgramPipeline
+    if (separable) {
+        glProgramParameteri(target.program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    }
+    // Ask the driver to keep a retrievable binary around for the cache
+    if (retrievable) {
+        glProgramParameteri(target.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(target.program);
+}
+
+bool Shader::buildComplete(const PendingBuild& build) {
+    // Neither check blocks: the worker flag is an atomic, and the completion
+    // status query is the whole point of the parallel compile extension
+    if (build.workerDone) {
+        return build.workerDone->load(std::memory_order_acquire);
+    }
+    if (!parallelCompile) {
+        return true;
+    }
+    GLint complete = GL_FALSE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+unsigned int Shader::checkBuild(const PendingBuild& build) {
+    try {
+        for (size_t i = 0; i < build.shaders.size(); i++) {
+            checkCompileErrors(build.shaders[i], build.labels[i]);
+        }
+        checkCompileErrors(build.program, "PROGRAM");
+    } catch (...) {
+        for (unsigned int shader : build.shaders) glDeleteShader(shader);
+        glDeleteProgram(build.program);
+        throw;
+    }
+    GL_CHECK("shader program linking");
     
     // Delete shaders as they're linked into our program now and no longer necessary
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (unsigned int shader : build.shaders) {
+        glDetachShader(build.program, shader);
+        glDeleteShader(shader);
+    }
+    return build.program;
+}
+
+void Shader::discardBuild(const PendingBuild& build) {
+    // A worker thread may still be compiling into the pending objects
+    if (build.workerDone) {
+        while (!build.workerDone->load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    for (unsigned int shader : build.shaders) glDeleteShader(shader);
+    if (build.program != 0) glDeleteProgram(build.program);
+}
+
+void Shader::finishBuild() {
+    std::shared_ptr<PendingBuild> build = std::move(pending);
+    
+    try {
+        ID = checkBuild(*build);
+    } catch (...) {
+        state = BuildState::Failed;
+        throw;
+    }
+    
+    storeCachedBinary(ID, build->key);
+    completeBuild(false, build->start);
+}
+
+void Shader::completeBuild(bool cacheHit, std::chrono::steady_clock::time_point start) {
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats.programs++;
+    stats.cacheHits += cacheHit ? 1 : 0;
+    stats.milliseconds += elapsed;
+    
+    adoptProgram();
+    
+    std::cout << "Shader program created with ID: " << ID << " (" << uniforms.size() << " active uniforms, "
+              << (cacheHit ? "binary cache" : "compiled") << ", " << elapsed << " ms)" << std::endl;
+}
+
+void Shader::adoptProgram() {
+    // Resolve every active uniform once so the render loop never asks the driver
+    reflectUniforms();
+    state = BuildState::Ready;
+    
+    // Per-program setup such as sampler units has to be redone after every link
+    for (const auto& setup : linkCallbacks) {
+        setup(*this);
+    }
+}
+
+bool Shader::isReady() {
+    if (state != BuildState::Compiling) {
+        return state == BuildState::Ready;
+    }
+    GL_SCOPE("Shader::isReady");
+    
+    if (!buildComplete(*pending)) {
+        return false;
+    }
+    
+    try {
+        finishBuild();
+    } catch (const std::exception& e) {
+        std::cerr << "Asynchronous shader build failed: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Shader::onLinked(std::function<void(Shader&)> setup) {
+    if (state == BuildState::Ready) {
+        setup(*this);
+    }
+    linkCallbacks.push_back(std::move(setup));
+}
+
+bool Shader::usesSourceFile(const std::string& fileName) const {
+    // Included files count too, so editing a shared include reloads every user
+    for (const std::string& file : includedFiles) {
+        if (std::filesystem::path(file).filename() == fileName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Shader::reload() {
+    // Programs built from memory have nothing to reload. An initial build
+    // still in flight is left alone; the next save triggers the reload.
+    if (sourceFiles.empty() || state == BuildState::Compiling) {
+        return false;
+    }
+    if (reloadPending) {
+        // Can't cancel a compile in flight; rebuild again once it lands
+        reloadQueued = true;
+        return false;
+    }
+    GL_SCOPE("Shader::reload");
+    
+    std::vector<StageSource> stages;
+    try {
+        stages = loadStages();
+    } catch (const std::exception& e) {
+        // Editors sometimes leave the file briefly missing or empty mid-save
+        std::cerr << "Hot reload could not read shader sources: " << e.what() << std::endl;
+        return false;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    uint64_t key = programKey(stages);
+    unsigned int cached = loadCachedBinary(key);
+    if (cached != 0) {
+        // An edit that was reverted: the old binary is still in the cache
+        swapProgram(cached);
+        return true;
+    }
+    
+    reloadPending = submitBuild(stages, key, start, true);
+    return true;
+}
+
+bool Shader::commitReload() {
+    if (!reloadPending || !buildComplete(*reloadPending)) {
+        return false;
+    }
+    GL_SCOPE("Shader::commitReload");
+    
+    std::shared_ptr<PendingBuild> build = std::move(reloadPending);
+    bool queued = reloadQueued;
+    reloadQueued = false;
+    
+    unsigned int program = 0;
+    try {
+        program = checkBuild(*build);
+    } catch (const std::exception& e) {
+        std::cerr << "Hot reload failed, keeping the previous program " << ID << ": " << e.what() << std::endl;
+        if (queued) reload();
+        return false;
+    }
+    
+    storeCachedBinary(program, build->key);
+    swapProgram(program);
+    
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build->start).count();
+    std::cout << "Hot reloaded shader program " << ID << " in " << elapsed << " ms" << std::endl;
+    
+    if (queued) reload();
+    return true;
+}
+
+void Shader::swapProgram(unsigned int program) {
+    // Draws already queued with the old program keep it alive until they finish
+    if (ID != 0) {
+        glDeleteProgram(ID);
+    }
+    ID = program;
+    adoptProgram();
+}
+
+std::string Shader::programCacheDirectory;
+Shader::BuildStats Shader::stats;
+
+void Shader::setProgramCacheDirectory(const std::string& directory) {
+    programCacheDirectory = directory;
+}
+
+Shader::BuildStats Shader::buildStats() {
+    return stats;
+}
+
+uint64_t Shader::programKey(const std::vector<StageSource>& stages) const {
+    // FNV-1a over everything that can invalidate a binary: the final sources
+    // (defines are injected into them) plus the driver identity
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* data, size_t length) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        // Separator so "ab"+"c" and "a"+"bc" hash differently
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+    };
+    
+    // A separable program links differently from a full one with the same stage
+    mix(&separable, sizeof(separable));
+    for (const StageSource& stage : stages) {
+        mix(&stage.type, sizeof(stage.type));
+        mix(stage.source.data(), stage.source.size());
+    }
+    
+    const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (renderer) mix(renderer, std::strlen(renderer));
+    if (version) mix(version, std::strlen(version));
+    
+    return hash;
+}
+
+// Header written in front of every cached program binary
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t key;
+};
+
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x42504f47; // "GOPB"
+
+static std::filesystem::path cachePathFor(const std::string& directory, uint64_t key) {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return std::filesystem::path(directory) / name.str();
+}
+
+static bool programBinariesSupported() {
+    static int formats = -1;
+    if (formats < 0) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats == 0) {
+            std::cout << "Driver exposes no program binary formats, shader cache disabled" << std::endl;
+        }
+    }
+    return formats > 0;
+}
+
+unsigned int Shader::loadCachedBinary(uint64_t key) {
+    if (programCacheDirectory.empty() || !programBinariesSupported()) {
+        return 0;
+    }
+    
+    std::ifstream file(cachePathFor(programCacheDirectory, key), std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+    
+    ProgramBinaryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != PROGRAM_BINARY_MAGIC || header.key != key) {
+        return 0;
+    }
+    
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        return 0;
+    }
+    
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    
+    // The driver may reject binaries after an update even with a matching key
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        std::cout << "Cached program binary rejected by driver, recompiling" << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void Shader::storeCachedBinary(unsigned int program, uint64_t key) {
+    if (programCacheDirectory.empty() || !programBinariesSupported()) {
+        return;
+    }
+    
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
     
-    std::cout << "Shader program created with ID: " << ID << std::endl;
+    std::error_code error;
+    std::filesystem::create_directories(programCacheDirectory, error);
+    
+    // Write to a temporary file and rename so a crash never leaves a torn binary
+    std::filesystem::path path = cachePathFor(programCacheDirectory, key);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Warning: could not write program cache " << temporary << std::endl;
+            return;
+        }
+        ProgramBinaryHeader header = {PROGRAM_BINARY_MAGIC, format, static_cast<uint32_t>(length), 0, key};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cerr << "Warning: could not store program cache " << path << ": " << error.message() << std::endl;
+    }
 }
 
 void Shader::use() {
     glUseProgram(ID);
-    checkGLError("using shader program");
+    GL_CHECK("using shader program");
+}
+
+unsigned int Shader::driverLookups = 0;
+
+unsigned int Shader::takeDriverLookups() {
+    unsigned int count = driverLookups;
+    driverLookups = 0;
+    return count;
+}
+
+void Shader::reflectUniforms() {
+    driverLookups += uniforms.build(ID);
+    
+    // Attach shared uniform blocks to their fixed binding points. GLSL 4.10
+    // has no layout(binding = N) for blocks, so this has to happen per link.
+    GLint blockCount = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    for (GLint i = 0; i < blockCount; i++) {
+        char blockName[128];
+        glGetActiveUniformBlockName(ID, i, sizeof(blockName), NULL, blockName);
+        GLuint binding;
+        if (uniformBlockBinding(blockName, binding)) {
+            glUniformBlockBinding(ID, i, binding);
+        }
+    }
+    
+    // Re-resolve any handles that were handed out before this link
+    for (size_t i = 0; i < slotNames.size(); i++) {
+        const UniformInfo* info = uniforms.find(slotNames[i]);
+        slotLocations[i] = info ? info->location : -1;
+    }
+}
+
+int Shader::resolveSlot(const std::string &name, GLenum expectedType) {
+    for (size_t i = 0; i < slotNames.size(); i++) {
+        if (slotNames[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    
+    const UniformInfo* info = uniforms.find(name);
+    if (state == BuildState::Compiling) {
+        // Resolved by reflectUniforms() once the asynchronous build finishes
+    } else if (!info) {
+        // Keep the slot anyway - the fallback shaders legitimately lack most uniforms
+        std::cout << "Uniform '" << name << "' is not active in shader " << ID << std::endl;
+    } else {
+        // Samplers are set with glProgramUniform1i, so an int handle is fine for them
+        bool samplerAsInt = expectedType == GL_INT &&
+            (info->type == GL_SAMPLER_2D || info->type == GL_SAMPLER_3D || info->type == GL_SAMPLER_2D_ARRAY);
+        bool boolAsInt = expectedType == GL_BOOL && info->type == GL_INT;
+        if (info->type != expectedType && !samplerAsInt && !boolAsInt) {
+            std::cerr << "Warning: Uniform '" << name << "' has GL type 0x" << std::hex << info->type
+                      << ", handle expects 0x" << expectedType << std::dec << std::endl;
+        }
+    }
+    
+    slotNames.push_back(name);
+    slotLocations.push_back(info ? info->location : -1);
+    return static_cast<int>(slotNames.size() - 1);
+}
+
+GLint Shader::locationOf(const std::string &name) const {
+    const UniformInfo* info = uniforms.find(name);
+    if (!info) {
+        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
+        return -1;
+    }
+    return info->location;
+}
+
+void Shader::set(UniformHandle<bool> handle, bool value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniform1i(ID, slotLocations[handle.slot], (int)value);
+    GL_CHECK("setting bool uniform");
+}
+
+void Shader::set(UniformHandle<int> handle, int value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniform1i(ID, slotLocations[handle.slot], value);
+    GL_CHECK("setting int uniform");
+}
+
+void Shader::set(UniformHandle<float> handle, float value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniform1f(ID, slotLocations[handle.slot], value);
+    GL_CHECK("setting float uniform");
+}
+
+void Shader::set(UniformHandle<glm::vec3> handle, const glm::vec3 &value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniform3fv(ID, slotLocations[handle.slot], 1, glm::value_ptr(value));
+    GL_CHECK("setting vec3 uniform");
+}
+
+void Shader::set(UniformHandle<glm::vec4> handle, const glm::vec4 &value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniform4fv(ID, slotLocations[handle.slot], 1, glm::value_ptr(value));
+    GL_CHECK("setting vec4 uniform");
+}
+
+void Shader::set(UniformHandle<glm::mat4> handle, const glm::mat4 &value) const {
+    if (!handle.valid() || slotLocations[handle.slot] == -1) return;
+    glProgramUniformMatrix4fv(ID, slotLocations[handle.slot], 1, GL_FALSE, glm::value_ptr(value));
+    GL_CHECK("setting mat4 uniform");
 }
 
 void Shader::setBool(const std::string &name, bool value) const {
-    int location = glGetUniformLocation(ID, name.c_str());
+    int location = locationOf(name);
     if (location == -1) {
-        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
         return;  // Skip setting the uniform
     }
-    glUniform1i(location, (int)value);
-    checkGLError("setting bool uniform");
+    glProgramUniform1i(ID, location, (int)value);
+    GL_CHECK("setting bool uniform");
 }
 
 void Shader::setInt(const std::string &name, int value) const {
-    int location = glGetUniformLocation(ID, name.c_str());
+    int location = locationOf(name);
     if (location == -1) {
-        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
         return;  // Skip setting the uniform
     }
-    glUniform1i(location, value);
-    checkGLError("setting int uniform");
+    glProgramUniform1i(ID, location, value);
+    GL_CHECK("setting int uniform");
 }
 
 void Shader::setFloat(const std::string &name, float value) const {
-    int location = glGetUniformLocation(ID, name.c_str());
+    int location = locationOf(name);
     if (location == -1) {
-        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
         return;  // Skip setting the uniform
     }
-    glUniform1f(location, value);
-    checkGLError("setting float uniform");
+    glProgramUniform1f(ID, location, value);
+    GL_CHECK("setting float uniform");
 }
 
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const {
-    int location = glGetUniformLocation(ID, name.c_str());
+    int location = locationOf(name);
     if (location == -1) {
-        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
         return;  // Skip setting the uniform
     }
-    glUniform3fv(location, 1, glm::value_ptr(value));
-    checkGLError("setting vec3 uniform");
+    glProgramUniform3fv(ID, location, 1, glm::value_ptr(value));
+    GL_CHECK("setting vec3 uniform");
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &value) const {
-    int location = glGetUniformLocation(ID, name.c_str());
+    int location = locationOf(name);
     if (location == -1) {
-        std::cerr << "Warning: Uniform '" << name << "' not found in shader" << std::endl;
         return;  // Skip setting the uniform
     }
-    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
-    checkGLError("setting mat4 uniform");
+    glProgramUniformMatrix4fv(ID, location, 1, GL_FALSE, glm::value_ptr(value));
+    GL_CHECK("setting mat4 uniform");
 }
 
-void Shader::checkCompileErrors(unsigned int shader, std::string type) {
+void Shader::checkCompileErrors(unsigned int shader, const std::string& type) {
     int success;
     char infoLog[1024];
     
@@ -171,11 +771,3 @@ void Shader::checkCompileErrors(unsigned int shader, std::string type) {
         }
     }
 }
-
-void Shader::checkGLError(const char* operation) const {
-    GLenum error;
-    while ((error = glGetError()) != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after " << operation << ": " 
-                  << error << " (0x" << std::hex << error << std::dec << ")" << std::endl;
-    }
-}
\ No newline at end of file
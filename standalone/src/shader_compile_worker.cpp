@@ -0,0 +1,87 @@
+#include "shader_compile_worker.h"
+
+#include <iostream>
+
+GLFWwindow* ShaderCompileWorker::context = nullptr;
+std::thread ShaderCompileWorker::thread;
+std::mutex ShaderCompileWorker::mutex;
+std::condition_variable ShaderCompileWorker::wake;
+std::deque<ShaderCompileWorker::Task> ShaderCompileWorker::tasks;
+bool ShaderCompileWorker::stopping = false;
+
+bool ShaderCompileWorker::start(GLFWwindow* mainWindow) {
+    if (context) {
+        return true;
+    }
+
+    // A 1x1 invisible window is the portable way to get a second GLFW context.
+    // It inherits the current window hints, so the context version matches.
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    context = glfwCreateWindow(1, 1, "Shader compile worker", NULL, mainWindow);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context) {
+        std::cerr << "Failed to create shared context for the shader compile worker" << std::endl;
+        return false;
+    }
+
+    stopping = false;
+    thread = std::thread(run);
+    std::cout << "Shader compile worker started on a shared context" << std::endl;
+    return true;
+}
+
+void ShaderCompileWorker::stop() {
+    if (!context) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+
+    glfwDestroyWindow(context);
+    context = nullptr;
+}
+
+bool ShaderCompileWorker::running() {
+    return context != nullptr;
+}
+
+std::shared_ptr<std::atomic<bool>> ShaderCompileWorker::submit(std::function<void()> task) {
+    auto done = std::make_shared<std::atomic<bool>>(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(Task{std::move(task), done});
+    }
+    wake.notify_one();
+    return done;
+}
+
+void ShaderCompileWorker::run() {
+    glfwMakeContextCurrent(context);
+
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                break;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task.work();
+
+        // Objects are only guaranteed visible to the other context once the
+        // commands that created them have completed
+        glFinish();
+        task.done->store(true, std::memory_order_release);
+    }
+
+    glfwMakeContextCurrent(NULL);
+}
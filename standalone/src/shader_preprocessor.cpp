@@ -0,0 +1,112 @@
+#include "shader_preprocessor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+// Returns true and the quoted path if the line is an #include directive
+static bool parseInclude(const std::string& line, std::string& target) {
+    size_t pos = line.find_first_not_of(" \t");
+    if (pos == std::string::npos || line[pos] != '#') {
+        return false;
+    }
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos || line.compare(pos, 7, "include") != 0) {
+        return false;
+    }
+    size_t open = line.find('"', pos + 7);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos) {
+        throw std::runtime_error("Malformed #include: " + line);
+    }
+    target = line.substr(open + 1, close - open - 1);
+    return true;
+}
+
+static bool isVersionLine(const std::string& line) {
+    size_t pos = line.find_first_not_of(" \t");
+    return pos != std::string::npos && line.compare(pos, 8, "#version") == 0;
+}
+
+static void appendDefines(std::string& out, const ShaderDefines& defines) {
+    for (const auto& define : defines) {
+        out += "#define " + define.first;
+        if (!define.second.empty()) {
+            out += " " + define.second;
+        }
+        out += "\n";
+    }
+}
+
+ShaderPreprocessor::Result ShaderPreprocessor::process(const std::string& path, const ShaderDefines& defines,
+                                                       const Loader& load) {
+    Result result;
+    std::string root = std::filesystem::path(path).parent_path().string();
+    expand(std::filesystem::path(path).lexically_normal().string(), root, load, result);
+    result.source = injectDefines(result.source, defines);
+    return result;
+}
+
+std::string ShaderPreprocessor::injectDefines(const std::string& source, const ShaderDefines& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    // Defines have to follow #version, which must stay the first directive
+    std::istringstream in(source);
+    std::string out;
+    std::string line;
+    int lineNumber = 0;
+    bool injected = false;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        out += line + "\n";
+        if (!injected && isVersionLine(line)) {
+            appendDefines(out, defines);
+            out += "#line " + std::to_string(lineNumber + 1) + " 0\n";
+            injected = true;
+        }
+    }
+    if (!injected) {
+        std::string prefix;
+        appendDefines(prefix, defines);
+        out = prefix + "#line 1 0\n" + out;
+    }
+    return out;
+}
+
+void ShaderPreprocessor::expand(const std::string& path, const std::string& root, const Loader& load,
+                                Result& result) {
+    int fileIndex = static_cast<int>(result.files.size());
+    result.files.push_back(path);
+
+    std::istringstream in(load(path));
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+
+        std::string target;
+        if (!parseInclude(line, target)) {
+            result.source += line + "\n";
+            continue;
+        }
+
+        std::filesystem::path resolved = target[0] == '/'
+            ? std::filesystem::path(root) / target.substr(1)
+            : std::filesystem::path(directory) / target;
+        std::string includePath = resolved.lexically_normal().string();
+
+        // Include-once, which also makes include cycles harmless: later
+        // includes of the same file become blank lines
+        if (std::find(result.files.begin(), result.files.end(), includePath) == result.files.end()) {
+            result.source += "#line 1 " + std::to_string(result.files.size()) + "\n";
+            expand(includePath, root, load, result);
+            result.source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+        } else {
+            result.source += "\n";
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include "shader_sources.h"
+#include "embedded_shaders.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+std::string ShaderSources::overrides;
+
+void ShaderSources::setOverrideDirectory(const std::string& directory) {
+    overrides = directory;
+    if (!overrides.empty()) {
+        std::cout << "Shader sources in " << overrides << " override the embedded copies" << std::endl;
+    }
+}
+
+const EmbeddedShader* ShaderSources::findEmbedded(std::string_view name) {
+    for (const EmbeddedShader* shader : EmbeddedShaders::all) {
+        if (shader->name == name) {
+            return shader;
+        }
+    }
+    return nullptr;
+}
+
+std::string ShaderSources::load(const std::string& name) {
+    if (!overrides.empty()) {
+        std::filesystem::path path = std::filesystem::path(overrides) / name;
+        std::error_code error;
+        if (std::filesystem::is_regular_file(path, error)) {
+            return readFile(path.string());
+        }
+    }
+
+    const EmbeddedShader* embedded = findEmbedded(name);
+    if (!embedded) {
+        throw std::runtime_error("No embedded shader named " + name);
+    }
+    return std::string(embedded->source);
+}
+
+std::string ShaderSources::readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Can't read shader source: " + path);
+    }
+
+    // Size the string up front and read straight into it
+    std::string source(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(source.data(), source.size())) {
+        throw std::runtime_error("Can't read shader source: " + path);
+    }
+    return source;
+}
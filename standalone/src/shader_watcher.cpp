@@ -0,0 +1,125 @@
+#include "shader_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+ShaderWatcher::ShaderWatcher(const std::string& directory) : directory(directory), fd(-1) {
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Shader hot reload disabled, inotify_init1 failed: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    // Editors either rewrite the file in place (close after write) or save a
+    // temporary and rename it over the original (moved to)
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Shader hot reload disabled, can't watch " << directory << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return;
+    }
+    
+    // inotify isn't recursive; shared includes live one level down (lib/)
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_directory()) {
+            inotify_add_watch(fd, entry.path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        }
+    }
+    std::cout << "Watching " << directory << " for shader changes" << std::endl;
+#else
+    std::cout << "Shader hot reload is only available on Linux" << std::endl;
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+void ShaderWatcher::watch(Shader* shader) {
+    if (shader && std::find(shaders.begin(), shaders.end(), shader) == shaders.end()) {
+        shaders.push_back(shader);
+    }
+}
+
+void ShaderWatcher::unwatch(Shader* shader) {
+    shaders.erase(std::remove(shaders.begin(), shaders.end(), shader), shaders.end());
+}
+
+std::vector<std::string> ShaderWatcher::readChangedFiles() {
+    std::vector<std::string> changed;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN: nothing (more) to read this frame
+            break;
+        }
+
+        for (char* cursor = buffer; cursor < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+            cursor += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::cerr << "Shader watcher event queue overflowed, some changes may be missed" << std::endl;
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+
+            // One save often produces several events for the same file
+            std::string name(event->name);
+            if (std::find(changed.begin(), changed.end(), name) == changed.end()) {
+                changed.push_back(name);
+            }
+        }
+    }
+#endif
+    return changed;
+}
+
+bool ShaderWatcher::update() {
+    if (fd < 0) {
+        return false;
+    }
+
+    // A reload that hits the program binary cache (a reverted edit) swaps
+    // the program in right away rather than through commitReload
+    bool swapped = false;
+    for (const std::string& name : readChangedFiles()) {
+        bool logged = false;
+        for (Shader* shader : shaders) {
+            if (!shader->usesSourceFile(name)) {
+                continue;
+            }
+            if (!logged) {
+                std::cout << "Shader source changed: " << name << std::endl;
+                logged = true;
+            }
+            unsigned int program = shader->ID;
+            shader->reload();
+            swapped = shader->ID != program || swapped;
+        }
+    }
+
+    // Swap in whatever finished compiling since the last frame
+    for (Shader* shader : shaders) {
+        swapped = shader->commitReload() || swapped;
+    }
+    return swapped;
+}
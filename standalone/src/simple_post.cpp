@@ -1,13 +1,17 @@
 // src/simple_post.cpp
 #include "simple_post.h"
+#include "embedded_shaders.h"
 #include <iostream>
 
 SimplePostProcessor::SimplePostProcessor(unsigned int width, unsigned int height) 
-    : width(width), height(height), framebuffer(0), textureColorBuffer(0), quadVAO(0) {
+    : width(width), height(height), framebuffer(0), textureColorBuffer(0), depthStencilBuffer(0), quadVAO(0) {
     
-    // Create a very simple shader for rendering to screen
+    // Create a very simple shader for rendering to screen, reusing the
+    // separable quad vertex stage the other post passes share
     try {
-        screenShader = new Shader("../shaders/quad.vert", "../shaders/simple_post.frag");
+        quadStage = Shader::variant(GL_VERTEX_SHADER, EmbeddedShaders::quad_vert);
+        screenShader = new Shader(GL_FRAGMENT_SHADER, EmbeddedShaders::simple_post_frag);
+        pipeline = new ProgramPipeline();
         std::cout << "Successfully loaded post-processing shaders" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Failed to load post-processing shaders: " << e.what() << std::endl;
@@ -20,8 +24,10 @@ SimplePostProcessor::SimplePostProcessor(unsigned int width, unsigned int height
 
 SimplePostProcessor::~SimplePostProcessor() {
     delete screenShader;
+    delete pipeline;
     glDeleteFramebuffers(1, &framebuffer);
     glDeleteTextures(1, &textureColorBuffer);
+    glDeleteRenderbuffers(1, &depthStencilBuffer);
     glDeleteVertexArrays(1, &quadVAO);
 }
 
@@ -38,7 +44,7 @@ void SimplePostProcessor::renderToScreen() {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    screenShader->use();
+    pipeline->use(*quadStage, *screenShader);
     screenShader->setInt("screenTexture", 0);
     
     glActiveTexture(GL_TEXTURE0);
@@ -64,11 +70,10 @@ void SimplePostProcessor::initFramebuffer() {
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorBuffer, 0);
     
     // Create renderbuffer for depth and stencil attachment
-    unsigned int rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glGenRenderbuffers(1, &depthStencilBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthStencilBuffer);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencilBuffer);
     
     // Check framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
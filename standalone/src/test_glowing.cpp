@@ -7,13 +7,26 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <cstdlib>
+#include <functional>
 #include <filesystem>
 #include <vector>
 #include <string>
 #include <iomanip>
 #include <sstream>
+#include <chrono>
 #include "shader.h"
+#include "shader_compile_worker.h"
+#include "shader_watcher.h"
+#include "embedded_shaders.h"
+#include "gl_debug.h"
+#include "uniform_buffer.h"
 #include "post_processor.h"  
+#include "frame_graph.h"
+#include "bloom_governor.h"
+#include "ore_field.h"
+#include "chunk.h"
+#include "chunk_mesher.h"
 #include "simple_text_renderer.h" // Using the simplified renderer
 
 // Settings
@@ -25,12 +38,62 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window, float &ambientLight, int &currentOreIndex, float &bloomIntensity, float &bloomThreshold);
 unsigned int loadTexture(const char* path);
 unsigned int createColorTexture(glm::vec3 color, int size = 16);
+const char* bloomModeName(BloomMode mode);
+std::size_t hashScene(const glm::mat4& model, int oreIndex, int sceneView, std::size_t sceneContent,
+                      float ambientLight, float bloomThreshold, bool glowingReady);
+
+// One configuration of the --measure-formats run
+struct FormatMeasurement {
+    const char* label;
+    unsigned int width, height;
+    PostTargetFormats formats;
+    double milliseconds;        // Average bloom GPU time
+    std::size_t bytes;          // Render target traffic of the whole frame
+};
+
+void reportFormatMeasurements(const std::vector<FormatMeasurement>& measurements);
+
+// One block count of the --benchmark-instances sweep
+struct InstanceMeasurement {
+    std::size_t blocks;
+    double frameMilliseconds;   // Summed over frames, averaged when reported
+    unsigned int frames;
+    double sceneMilliseconds;   // Scene pass GPU time, summed over samples
+    unsigned int sceneSamples;
+};
+
+void reportInstanceMeasurements(const std::vector<InstanceMeasurement>& measurements);
+
+// Mesh every face, the visible faces and greedy quads of a few kinds of
+// chunk on the CPU, and print the quad counts and meshing times
+void runMeshingBenchmark();
+
+// The ore field shown with F: FIELD_BLOCKS blocks of every ore type, spaced
+// so the inner ones show through the gaps
+const std::size_t FIELD_BLOCKS = 4096;
+const float FIELD_SPACING = 1.5f;
+
+// Sections in the terrain chunk shown with F
+const int CHUNK_SECTIONS = 2;
+
+// What the scene pass draws; F cycles through them
+enum class SceneView {
+    Cube,           // The current ore on one cube
+    OreField,       // Instanced blocks of every ore
+    Chunk           // Meshed terrain with ore veins
+};
 
 // Global variables
 float ambientLight = 0.5f;      // Ambient light level (0.0 = dark, 1.0 = bright)
 int currentOreIndex = 0;        // Current ore being displayed
 float bloomIntensity = 1.0f;    // Bloom effect intensity
 float bloomThreshold = 0.5f;    // Brightness threshold for bloom effect
+float bloomRadius = 12.0f;      // Glow reach in pixels
+bool paused = false;            // Stop the rotation; the scene is then static
+float rotation = 0.0f;          // Cube rotation angle in radians
+SceneView sceneView = SceneView::Cube;
+MeshingMode chunkMeshingMode = MeshingMode::Greedy;
+bool remeshChunk = false;       // Rebuild the chunk mesh in chunkMeshingMode
 
 // Track previous values to detect changes
 static float prev_ambientLight = ambientLight;
@@ -40,7 +103,12 @@ static int prev_oreIndex = 0;
 
 // Post-processor instance
 PostProcessor* postProcessor = nullptr;
+FrameGraph* frameGraph = nullptr;
+GpuPassTimer* passTimer = nullptr;       // Per-pass GPU times of each frame graph
+BloomGovernor* bloomGovernor = nullptr;
+bool dumpFrameGraph = false;    // Print the next compiled frame graph
 SimpleTextRenderer* textRenderer = nullptr; // Using our simple renderer instead
+OreFieldRenderer* oreField = nullptr;
 
 // State for value change indicators
 struct ValueChangeIndicator {
@@ -92,6 +160,123 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     }
 }
 
+const char* bloomModeName(BloomMode mode) {
+    switch (mode) {
+        case BloomMode::MipChain: return "mip chain";
+        case BloomMode::Compute: return "compute";
+        case BloomMode::Temporal: return "temporal";
+        default: return "ping-pong";
+    }
+}
+
+std::size_t hashScene(const glm::mat4& model, int oreIndex, int sceneView, std::size_t sceneContent,
+                      float ambientLight, float bloomThreshold, bool glowingReady) {
+    // The camera and projection are fixed, so these are all the scene depends on
+    std::size_t seed = 0;
+    auto combine = [&seed](std::size_t value) {
+        seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            combine(std::hash<float>()(model[column][row]));
+        }
+    }
+    combine(std::hash<int>()(oreIndex));
+    combine(std::hash<int>()(sceneView));
+    combine(std::hash<std::size_t>()(sceneContent));
+    combine(std::hash<float>()(ambientLight));
+    combine(std::hash<float>()(bloomThreshold));
+    combine(std::hash<bool>()(glowingReady));
+    return seed;
+}
+
+void reportFormatMeasurements(const std::vector<FormatMeasurement>& measurements) {
+    std::cout << "Target format measurement (bloom GPU time, render target bytes per frame):" << std::endl;
+    for (std::size_t i = 0; i < measurements.size(); i++) {
+        const FormatMeasurement& m = measurements[i];
+        std::cout << "  " << std::left << std::setw(22) << m.label << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(8) << m.milliseconds << " ms "
+                  << std::setprecision(1) << std::setw(8) << m.bytes / (1024.0 * 1024.0) << " MB";
+        // Every odd entry is the packed format at the resolution of the one before
+        if (i % 2 == 1) {
+            const FormatMeasurement& base = measurements[i - 1];
+            std::cout << std::showpos << "  (" << m.milliseconds - base.milliseconds << " ms, "
+                      << (static_cast<double>(m.bytes) - static_cast<double>(base.bytes)) / (1024.0 * 1024.0)
+                      << " MB)" << std::noshowpos;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void reportInstanceMeasurements(const std::vector<InstanceMeasurement>& measurements) {
+    std::cout << "Instanced ore field benchmark (average frame time, scene pass GPU time):" << std::endl;
+    for (const InstanceMeasurement& m : measurements) {
+        double frame = m.frames > 0 ? m.frameMilliseconds / m.frames : 0.0;
+        double scene = m.sceneSamples > 0 ? m.sceneMilliseconds / m.sceneSamples : 0.0;
+        double triangles = static_cast<double>(m.blocks) * 12.0;
+        std::cout << "  " << std::right << std::setw(8) << m.blocks << " blocks " << std::fixed
+                  << std::setprecision(3) << std::setw(9) << frame << " ms frame " << std::setw(9) << scene
+                  << " ms scene  (" << std::setprecision(1) << std::setw(7)
+                  << (scene > 0.0 ? triangles / (scene * 1000.0) : 0.0) << " M triangles/s)" << std::endl;
+    }
+}
+
+// Time mesher over repetitions of chunk, in milliseconds per mesh
+static double timeMeshing(const ChunkMesher& mesher, const Chunk& chunk, int repetitions, ChunkMeshData& data) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++) {
+        data = mesher.mesh(chunk);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+void runMeshingBenchmark() {
+    BlockPalette palette;
+    for (std::size_t i = 0; i < palette.size(); i++) {
+        palette[i] = static_cast<std::uint32_t>(i);
+    }
+    const ChunkMesher faceMesher(palette, MeshingMode::Faces);
+    const ChunkMesher greedyMesher(palette, MeshingMode::Greedy);
+    const int REPETITIONS = 50;
+    
+    // Generated terrain, a solid block of stone, and stone shot through with
+    // random glass (the greedy mesher's worst case: little to merge)
+    std::vector<std::pair<std::string, Chunk>> chunks;
+    for (unsigned int seed = 1; seed <= 3; seed++) {
+        chunks.emplace_back("terrain (seed " + std::to_string(seed) + ")", Chunk(4));
+        chunks.back().second.generateTerrain(seed);
+    }
+    chunks.emplace_back("solid stone", Chunk(4));
+    chunks.emplace_back("stone and glass", Chunk(4));
+    std::srand(1);
+    for (std::size_t c = chunks.size() - 2; c < chunks.size(); c++) {
+        Chunk& chunk = chunks[c].second;
+        for (int y = 0; y < chunk.height(); y++) {
+            for (int z = 0; z < CHUNK_WIDTH; z++) {
+                for (int x = 0; x < CHUNK_WIDTH; x++) {
+                    bool glass = c == chunks.size() - 1 && std::rand() % 4 == 0;
+                    chunk.set(x, y, z, glass ? Block::Glass : Block::Stone);
+                }
+            }
+        }
+    }
+    
+    std::cout << "Chunk meshing benchmark (16x64x16 chunks, quads and CPU time per mesh):" << std::endl;
+    for (const auto& entry : chunks) {
+        ChunkMeshData faces, greedy;
+        double faceTime = timeMeshing(faceMesher, entry.second, REPETITIONS, faces);
+        double greedyTime = timeMeshing(greedyMesher, entry.second, REPETITIONS, greedy);
+        std::cout << "  " << std::left << std::setw(20) << entry.first << std::right
+                  << std::setw(7) << ChunkMesher::naiveQuadCount(entry.second) << " all faces "
+                  << std::setw(6) << faces.quadCount() << " visible " << std::fixed << std::setprecision(3)
+                  << std::setw(7) << faceTime << " ms " << std::setw(6) << greedy.quadCount() << " greedy "
+                  << std::setw(7) << greedyTime << " ms  (" << std::setprecision(1)
+                  << (greedy.quadCount() > 0 ? static_cast<double>(faces.quadCount()) / greedy.quadCount() : 0.0)
+                  << "x fewer triangles)" << std::endl;
+    }
+}
+
 // Implementation for processInput function
 void processInput(GLFWwindow* window, float &ambientLight, int &currentOreIndex, float &bloomIntensity, float &bloomThreshold) {
     // Check for escape key to close the window
@@ -159,6 +344,133 @@ void processInput(GLFWwindow* window, float &ambientLight, int &currentOreIndex,
         bloomIntensityIndicator.decreasing = true;
     }
     
+    // Cycle through the bloom modes this context supports with B
+    static bool bloomKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
+        if (!bloomKeyPressed && postProcessor) {
+            BloomMode mode = postProcessor->getBloomMode();
+            do {
+                mode = mode == BloomMode::PingPong ? BloomMode::MipChain
+                     : mode == BloomMode::MipChain ? BloomMode::Compute
+                     : mode == BloomMode::Compute ? BloomMode::Temporal : BloomMode::PingPong;
+            } while (!postProcessor->setBloomMode(mode));
+            std::cout << "Bloom mode: " << bloomModeName(mode) << std::endl;
+            bloomKeyPressed = true;
+        }
+    } else {
+        bloomKeyPressed = false;
+    }
+    
+    // Toggle between the MRT bright buffer and the extract pass with E
+    static bool sourceKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) {
+        if (!sourceKeyPressed && postProcessor) {
+            bool extract = postProcessor->getBloomSource() == BloomSource::BrightBuffer;
+            postProcessor->setBloomSource(extract ? BloomSource::Extract : BloomSource::BrightBuffer);
+            std::cout << "Bloom source: " << (extract ? "extract pass" : "bright buffer") << std::endl;
+            sourceKeyPressed = true;
+        }
+    } else {
+        sourceKeyPressed = false;
+    }
+    
+    // Toggle the bloom quality governor with Q
+    static bool governorKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+        if (!governorKeyPressed && bloomGovernor) {
+            bloomGovernor->setEnabled(!bloomGovernor->isEnabled());
+            std::cout << "Bloom governor: " << (bloomGovernor->isEnabled() ? "on" : "off") << std::endl;
+            governorKeyPressed = true;
+        }
+    } else {
+        governorKeyPressed = false;
+    }
+    
+    // Toggle auto-exposure with X
+    static bool exposureKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
+        if (!exposureKeyPressed && postProcessor) {
+            ExposureSettings exposure = postProcessor->getExposure();
+            exposure.enabled = !exposure.enabled;
+            postProcessor->setExposure(exposure);
+            std::cout << "Auto-exposure: " << (exposure.enabled ? "on" : "off") << std::endl;
+            exposureKeyPressed = true;
+        }
+    } else {
+        exposureKeyPressed = false;
+    }
+    
+    // Cycle the tone mapping operator with T; the grading LUT is rebaked
+    static bool toneMapKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) {
+        if (!toneMapKeyPressed && postProcessor) {
+            GradingParameters grading = postProcessor->getGrading().getParameters();
+            grading.toneMap = grading.toneMap == ToneMapOperator::Reinhard ? ToneMapOperator::ACES
+                            : grading.toneMap == ToneMapOperator::ACES ? ToneMapOperator::Filmic
+                            : grading.toneMap == ToneMapOperator::Filmic ? ToneMapOperator::Linear
+                            : ToneMapOperator::Reinhard;
+            postProcessor->getGrading().setParameters(grading);
+            std::cout << "Tone mapping: " << toneMapOperatorName(grading.toneMap) << std::endl;
+            toneMapKeyPressed = true;
+        }
+    } else {
+        toneMapKeyPressed = false;
+    }
+    
+    // Pause the rotation with P. A paused scene is static: its targets are
+    // kept, so unchanged frames skip the scene pass as well as the bloom.
+    static bool pauseKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS) {
+        if (!pauseKeyPressed && postProcessor) {
+            paused = !paused;
+            postProcessor->setStaticScene(paused);
+            std::cout << (paused ? "Paused" : "Resumed") << std::endl;
+            pauseKeyPressed = true;
+        }
+    } else {
+        pauseKeyPressed = false;
+    }
+    
+    // Cycle the single cube, the instanced ore field and the terrain chunk with F
+    static bool fieldKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS) {
+        if (!fieldKeyPressed && oreField) {
+            sceneView = sceneView == SceneView::Cube ? SceneView::OreField
+                      : sceneView == SceneView::OreField ? SceneView::Chunk
+                      : SceneView::Cube;
+            if (postProcessor) postProcessor->resetBloomHistory();
+            std::cout << (sceneView == SceneView::OreField ? "Ore field: " + std::to_string(oreField->instanceCount()) + " blocks"
+                        : sceneView == SceneView::Chunk ? std::string("Terrain chunk")
+                        : std::string("Single cube")) << std::endl;
+            fieldKeyPressed = true;
+        }
+    } else {
+        fieldKeyPressed = false;
+    }
+    
+    // Switch the chunk between per-face and greedy meshing with M
+    static bool meshKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS) {
+        if (!meshKeyPressed) {
+            chunkMeshingMode = chunkMeshingMode == MeshingMode::Greedy ? MeshingMode::Faces : MeshingMode::Greedy;
+            remeshChunk = true;
+            meshKeyPressed = true;
+        }
+    } else {
+        meshKeyPressed = false;
+    }
+    
+    // Print the compiled frame graph with G
+    static bool graphKeyPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS) {
+        if (!graphKeyPressed) {
+            dumpFrameGraph = true;
+            graphKeyPressed = true;
+        }
+    } else {
+        graphKeyPressed = false;
+    }
+    
     // Adjust bloom threshold with A/D keys
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
         bloomThreshold += 0.01f;
@@ -253,21 +565,37 @@ unsigned int createColorTexture(glm::vec3 color, int size) {
     return textureID;
 }
 
-int main() {
+int main(int argc, char** argv) {
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         return -1;
     }
     
-    // Configure GLFW for macOS
+    // Configure GLFW for macOS (4.1). Elsewhere ask for 4.3 first, which
+    // enables the compute-shader bloom, and fall back to 4.1 below
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+#ifdef __APPLE__
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+#endif
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#ifndef NDEBUG
+    // Debug contexts report more through KHR_debug; release builds skip the overhead
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
+#endif
     
     // Create window
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Minecraft Glowing Ore Test", NULL, NULL);
+#ifndef __APPLE__
+    if (!window) {
+        std::cout << "OpenGL 4.3 context not available, falling back to 4.1" << std::endl;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Minecraft Glowing Ore Test", NULL, NULL);
+    }
+#endif
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -284,6 +612,45 @@ int main() {
         return -1;
     }
     
+    // Route GL errors through the driver's debug callback. Pass --gl-sync to
+    // get errors reported inside the offending call while debugging.
+    // Shaders are embedded in the binary; pass --shader-dir <dir> (e.g. the
+    // source tree's shaders/) to use and hot reload files from disk instead.
+    // --measure-formats times the post chain with RGBA16F and packed targets
+    // at 1080p and 4K, prints the comparison and exits. --bloom-budget <ms>
+    // sets the GPU time the bloom governor holds the bloom passes to.
+    // --benchmark-instances times the instanced ore field from 1K to 1M
+    // blocks, prints the frame times and exits. --benchmark-meshing compares
+    // the chunk meshers on the CPU and exits.
+    bool synchronousGLErrors = false;
+    bool measureFormats = false;
+    bool benchmarkInstances = false;
+    bool benchmarkMeshing = false;
+    double bloomBudget = 4.0;
+    std::string shaderDirectory;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--gl-sync") synchronousGLErrors = true;
+        if (arg == "--measure-formats") measureFormats = true;
+        if (arg == "--benchmark-instances") benchmarkInstances = true;
+        if (arg == "--benchmark-meshing") benchmarkMeshing = true;
+        if (arg == "--shader-dir" && i + 1 < argc) shaderDirectory = argv[++i];
+        if (arg == "--bloom-budget" && i + 1 < argc) bloomBudget = std::atof(argv[++i]);
+    }
+    if (benchmarkMeshing) {
+        runMeshingBenchmark();
+        glfwTerminate();
+        return 0;
+    }
+    ShaderSources::setOverrideDirectory(shaderDirectory);
+    GLDebug::install(synchronousGLErrors);
+    
+    // Compile shaders in the background: in the driver when it supports
+    // parallel compilation, otherwise on a worker thread with a shared context
+    if (!Shader::initParallelCompile()) {
+        ShaderCompileWorker::start(window);
+    }
+    
     // Enable depth test
     glEnable(GL_DEPTH_TEST);
     
@@ -294,10 +661,19 @@ int main() {
     // Print current directory to help with debugging file paths
     std::cout << "Current working directory: " << std::filesystem::current_path() << std::endl;
     
+    // Keep linked program binaries between runs so warm starts skip compilation
+    Shader::setProgramCacheDirectory("shader_cache");
+    
     // Initialize post-processor
     try {
-        postProcessor = new PostProcessor(SCR_WIDTH, SCR_HEIGHT);
+        postProcessor = new PostProcessor(SCR_WIDTH, SCR_HEIGHT, ShaderBuildMode::Async);
         std::cout << "Post-processor initialized successfully with bloom effect" << std::endl;
+        frameGraph = new FrameGraph(postProcessor->getRenderTargets());
+        passTimer = new GpuPassTimer();
+        bloomGovernor = new BloomGovernor(*postProcessor, bloomBudget);
+        ExposureSettings exposure;
+        exposure.enabled = true;
+        postProcessor->setExposure(exposure);
     } catch (const std::exception& e) {
         std::cerr << "Failed to initialize post-processor: " << e.what() << std::endl;
         return -1;
@@ -312,21 +688,71 @@ int main() {
         // Continue without text rendering
     }
     
-    // Load and compile shaders - first try the glowing shaders, fall back to basic if they don't exist
-    Shader* activeShader = nullptr;
+    // The basic shader is tiny, so build it up front; it renders the first
+    // frames (and stays in use if the glowing shaders fail to build)
+    Shader* fallbackShader = nullptr;
+    try {
+        fallbackShader = new Shader(EmbeddedShaders::basic_vert, EmbeddedShaders::basic_frag);
+        std::cout << "Successfully loaded basic shaders as fallback" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load basic shaders: " << e.what() << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    
+    // Submit the glowing shaders without waiting for them
+    Shader* glowingShader = nullptr;
     try {
-        activeShader = new Shader("shaders/glowing.vert", "shaders/glowing.frag");
-        std::cout << "Successfully loaded glowing shaders" << std::endl;
+        glowingShader = new Shader(EmbeddedShaders::glowing_vert, EmbeddedShaders::glowing_frag, {},
+                                   ShaderBuildMode::Async);
+        std::cout << "Submitted glowing shaders" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "Failed to load glowing shaders, falling back to basic: " << e.what() << std::endl;
-        try {
-            activeShader = new Shader("shaders/basic.vert", "shaders/basic.frag");
-            std::cout << "Successfully loaded basic shaders as fallback" << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "Failed to load basic shaders too: " << e.what() << std::endl;
-            glfwTerminate();
-            return -1;
-        }
+    }
+    
+    // The same shaders built for the instanced ore field and for chunk meshes
+    Shader* fieldShader = nullptr;
+    Shader* chunkShader = nullptr;
+    try {
+        fieldShader = new Shader(EmbeddedShaders::glowing_vert, EmbeddedShaders::glowing_frag, {{"ORE_FIELD", "1"}},
+                                 ShaderBuildMode::Async);
+        chunkShader = new Shader(EmbeddedShaders::glowing_vert, EmbeddedShaders::glowing_frag,
+                                 {{"ORE_FIELD", "1"}, {"CHUNK_MESH", "1"}}, ShaderBuildMode::Async);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load ore field shaders: " << e.what() << std::endl;
+    }
+    
+    // Camera, lighting and material state live in shared uniform blocks that
+    // are uploaded once per frame and bound by binding point
+    UniformBlock<FrameConstants>* frameBlock = new UniformBlock<FrameConstants>(FRAME_BLOCK_BINDING);
+    UniformBlock<MaterialConstants>* materialBlock = new UniformBlock<MaterialConstants>(MATERIAL_BLOCK_BINDING);
+    
+    if (glowingShader) {
+        // Texture units are fixed, so bind the samplers to them once per link
+        glowingShader->onLinked([](Shader& shader) {
+            shader.setInt("diffuseTexture", 0);
+            shader.setInt("emissiveTexture", 1);
+            shader.setInt("exposureState", 2);
+        });
+    }
+    for (Shader* shader : {fieldShader, chunkShader}) {
+        if (shader) shader->onLinked([](Shader& shader) {
+            shader.setInt("diffuseTexture", 0);
+            shader.setInt("emissiveTexture", 1);
+            shader.setInt("exposureState", 2);
+        });
+    }
+    
+    // With --shader-dir, edit any file there while running and the affected
+    // programs are rebuilt in the background and swapped in between frames
+    ShaderWatcher* shaderWatcher = nullptr;
+    if (!shaderDirectory.empty()) {
+        shaderWatcher = new ShaderWatcher(shaderDirectory);
+        shaderWatcher->watch(glowingShader);
+        shaderWatcher->watch(fallbackShader);
+        if (fieldShader) shaderWatcher->watch(fieldShader);
+        if (chunkShader) shaderWatcher->watch(chunkShader);
+        postProcessor->watchShaders(*shaderWatcher);
     }
     
     // Set up vertex data for a Minecraft-style cube
@@ -494,7 +920,7 @@ int main() {
         // Iron ore
         try {
             iron.diffuseMap = loadTexture("textures/iron/diffuse.png");
-            diamond.emissiveMap = loadTexture("textures/iron/emissive.png");
+            iron.emissiveMap = loadTexture("textures/iron/emissive.png");
             std::cout << "Iron textures loaded successfully" << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "Failed to load iron textures, using fallback colors: " << e.what() << std::endl;
@@ -539,6 +965,75 @@ int main() {
         }
     }
     
+    // Every ore type in one instanced draw (F). The field's materials are the
+    // ores followed by the blocks only the terrain chunk uses.
+    const int fieldOreTypes = static_cast<int>(ores.size());
+    Chunk terrain(CHUNK_SECTIONS);
+    ChunkMesh* chunkMesh = nullptr;
+    BlockPalette palette;
+    if (fieldShader && chunkShader) {
+        std::vector<OreMaterial> materials;
+        for (const OreProperties& ore : ores) {
+            materials.push_back({ore.color, ore.glowStrength, ore.diffuseMap, ore.emissiveMap});
+        }
+        
+        // Blocks without a texture of their own: host rocks don't glow, and
+        // the ores missing from the list above get a plain color
+        unsigned int noGlow = createColorTexture(glm::vec3(0.0f));
+        unsigned int fullGlow = createColorTexture(glm::vec3(1.0f));
+        auto addMaterial = [&](glm::vec3 diffuse, glm::vec3 glow, float strength) {
+            materials.push_back({glow, strength, createColorTexture(diffuse), strength > 0.0f ? fullGlow : noGlow});
+            return static_cast<std::uint32_t>(materials.size() - 1);
+        };
+        auto oreLayer = [&](const std::string& name, std::uint32_t fallback) {
+            for (std::size_t i = 0; i < ores.size(); i++) {
+                if (ores[i].name == name) return static_cast<std::uint32_t>(i);
+            }
+            return fallback;
+        };
+        
+        palette[static_cast<std::size_t>(Block::Air)] = 0;
+        palette[static_cast<std::size_t>(Block::Glass)] = addMaterial(glm::vec3(0.75f, 0.85f, 0.9f), glm::vec3(0.0f), 0.0f);
+        palette[static_cast<std::size_t>(Block::Stone)] = addMaterial(glm::vec3(0.45f), glm::vec3(0.0f), 0.0f);
+        palette[static_cast<std::size_t>(Block::Deepslate)] = addMaterial(glm::vec3(0.27f, 0.27f, 0.3f), glm::vec3(0.0f), 0.0f);
+        palette[static_cast<std::size_t>(Block::Netherrack)] = addMaterial(glm::vec3(0.4f, 0.15f, 0.15f), glm::vec3(0.0f), 0.0f);
+        std::uint32_t coal = addMaterial(glm::vec3(0.2f), glm::vec3(1.0f, 0.5f, 0.2f), 0.8f);
+        std::uint32_t quartz = addMaterial(glm::vec3(0.85f, 0.82f, 0.78f), glm::vec3(1.0f, 0.95f, 0.9f), 1.2f);
+        std::uint32_t debris = addMaterial(glm::vec3(0.35f, 0.25f, 0.2f), glm::vec3(0.9f, 0.5f, 0.3f), 1.0f);
+        const std::pair<Block, std::uint32_t> ORE_LAYERS[] = {
+            {Block::CoalOre, coal},
+            {Block::IronOre, oreLayer("Iron Ore", coal)},
+            {Block::GoldOre, oreLayer("Gold Ore", coal)},
+            {Block::DiamondOre, oreLayer("Diamond Ore", coal)},
+            {Block::LapisOre, oreLayer("Lapis Ore", coal)},
+            {Block::RedstoneOre, oreLayer("Redstone Ore", coal)},
+            {Block::EmeraldOre, oreLayer("Emerald Ore", coal)},
+            {Block::CopperOre, oreLayer("Copper Ore", coal)}
+        };
+        for (const auto& ore : ORE_LAYERS) {
+            // Deepslate variants glow the same
+            palette[static_cast<std::size_t>(ore.first)] = ore.second;
+            palette[static_cast<std::size_t>(deepslateVariant(ore.first))] = ore.second;
+        }
+        palette[static_cast<std::size_t>(Block::NetherQuartzOre)] = quartz;
+        palette[static_cast<std::size_t>(Block::NetherGoldOre)] = oreLayer("Gold Ore", coal);
+        palette[static_cast<std::size_t>(Block::AncientDebris)] = debris;
+        
+        oreField = new OreFieldRenderer(materials);
+        oreField->setInstances(OreFieldRenderer::generateField(FIELD_BLOCKS, fieldOreTypes, FIELD_SPACING));
+        
+        // The layers are copied into the field's arrays
+        for (std::size_t i = ores.size(); i < materials.size(); i++) {
+            glDeleteTextures(1, &materials[i].diffuseMap);
+        }
+        glDeleteTextures(1, &noGlow);
+        glDeleteTextures(1, &fullGlow);
+        
+        terrain.generateTerrain(1);
+        chunkMesh = new ChunkMesh();
+        remeshChunk = true;
+    }
+    
     // Camera position
     glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
     
@@ -548,11 +1043,61 @@ int main() {
     std::cout << " - Left/Right arrows: Switch between ore types" << std::endl;
     std::cout << " - W/S keys: Adjust bloom intensity" << std::endl;
     std::cout << " - A/D keys: Adjust bloom threshold" << std::endl;
+    std::cout << " - B key: Cycle bloom modes" << std::endl;
+    std::cout << " - E key: Toggle bloom source (bright buffer / extract pass)" << std::endl;
+    std::cout << " - Q key: Toggle the bloom quality governor" << std::endl;
+    std::cout << " - T key: Cycle tone mapping operators" << std::endl;
+    std::cout << " - X key: Toggle auto-exposure" << std::endl;
+    std::cout << " - F key: Cycle the cube, the instanced ore field and a terrain chunk" << std::endl;
+    std::cout << " - M key: Toggle greedy meshing of the terrain chunk" << std::endl;
+    std::cout << " - P key: Pause the rotation (static scene)" << std::endl;
+    std::cout << " - G key: Print the frame graph" << std::endl;
     std::cout << " - ESC: Exit program" << std::endl;
     
+    // Format measurement runs, each a wide/packed pair at one resolution
+    std::vector<FormatMeasurement> measurements;
+    if (measureFormats) {
+        // Measure the formats at a fixed bloom quality
+        bloomGovernor->setEnabled(false);
+        PostTargetFormats wide;
+        wide.scene = wide.bright = wide.bloom = GL_RGBA16F;
+        PostTargetFormats packed;
+        measurements = {
+            {"1080p RGBA16F", 1920, 1080, wide, 0.0, 0},
+            {"1080p R11F_G11F_B10F", 1920, 1080, packed, 0.0, 0},
+            {"4K RGBA16F", 3840, 2160, wide, 0.0, 0},
+            {"4K R11F_G11F_B10F", 3840, 2160, packed, 0.0, 0}
+        };
+    }
+    std::size_t measureIndex = 0;
+    int measureWarmup = -1;     // Frames to settle after switching; -1 before the first switch
+    
+    // Instance benchmark runs. Without vsync and with a fixed bloom quality,
+    // frame time follows the field.
+    std::vector<InstanceMeasurement> instanceRuns;
+    if (benchmarkInstances && oreField) {
+        bloomGovernor->setEnabled(false);
+        glfwSwapInterval(0);
+        sceneView = SceneView::OreField;
+        instanceRuns = {
+            {1000, 0.0, 0, 0.0, 0},
+            {10000, 0.0, 0, 0.0, 0},
+            {100000, 0.0, 0, 0.0, 0},
+            {1000000, 0.0, 0, 0.0, 0}
+        };
+    }
+    std::size_t instanceIndex = 0;
+    int instanceWarmup = -1;    // As measureWarmup
+    unsigned int lastPassFrame = 0;
+    
     // Timing variables for animation
     float lastFrame = 0.0f;
     float deltaTime = 0.0f;
+    unsigned long frameCount = 0;
+    bool startupReported = false;
+    
+    // Lookups done while building shaders don't count against the render loop
+    std::cout << "Driver uniform lookups during startup: " << Shader::takeDriverLookups() << std::endl;
     
     // Render loop
     while (!glfwWindowShouldClose(window)) {
@@ -574,158 +1119,301 @@ int main() {
         if (oreChangeIndicator.timeLeft > 0.0f)
             oreChangeIndicator.timeLeft -= deltaTime;
         
-        // Begin rendering to post-processing framebuffer
-        postProcessor->beginRender();
+        // Pick up edited shaders; a relink re-resolves uniforms, which
+        // shouldn't count as a render loop lookup
+        if (shaderWatcher) {
+            // A new program can change the picture without changing the inputs
+            if (shaderWatcher->update()) postProcessor->invalidateCache();
+            if (startupReported) Shader::takeDriverLookups();
+        }
+        
+        GL_SCOPE("frame");
         
-        // Clear framebuffer
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (remeshChunk && chunkMesh) {
+            ChunkMeshData meshData = ChunkMesher(palette, chunkMeshingMode).mesh(terrain);
+            chunkMesh->upload(meshData);
+            std::cout << "Terrain chunk (" << (chunkMeshingMode == MeshingMode::Greedy ? "greedy" : "faces") << "): "
+                      << meshData.quadCount() << " quads for " << ChunkMesher::naiveQuadCount(terrain)
+                      << " block faces (" << meshData.triangleCount() << " triangles)" << std::endl;
+            remeshChunk = false;
+        }
         
-        // Activate shader
-        activeShader->use();
+        // Render with the glowing shader once it has finished building
+        bool glowingReady = glowingShader && glowingShader->isReady();
+        Shader* activeShader = glowingReady ? glowingShader : fallbackShader;
+        // The field and the chunk only have their own programs; until those
+        // are built, show the cube
+        bool drawField = sceneView == SceneView::OreField && fieldShader && fieldShader->isReady();
+        bool drawChunk = sceneView == SceneView::Chunk && chunkShader && chunkShader->isReady() && chunkMesh;
         
-        // Set camera-related uniforms
+        // Camera and scene transforms
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         glm::mat4 model = glm::mat4(1.0f);
-        model = glm::rotate(model, (float)glfwGetTime() * 0.5f, glm::vec3(0.5f, 1.0f, 0.0f));
-        
-        // First check if the shader has these uniforms (it might be the basic shader as fallback)
-        GLint modelLoc = glGetUniformLocation(activeShader->ID, "model");
-        if (modelLoc != -1) {
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        }
-        
-        GLint viewLoc = glGetUniformLocation(activeShader->ID, "view");
-        if (viewLoc != -1) {
-            glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        if (!paused) rotation += deltaTime * 0.5f;
+        model = glm::rotate(model, rotation, glm::vec3(0.5f, 1.0f, 0.0f));
+        if (drawField) {
+            // Shrink the field to the cube's size on screen, whatever its block count
+            int side = OreFieldRenderer::fieldSide(oreField->instanceCount());
+            model = glm::scale(model, glm::vec3(1.0f / (side * FIELD_SPACING)));
         }
-        
-        GLint projLoc = glGetUniformLocation(activeShader->ID, "projection");
-        if (projLoc != -1) {
-            glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        }
-        
-        // Set ore-specific properties and glowing parameters if the shader supports them
-        GLint viewPosLoc = glGetUniformLocation(activeShader->ID, "viewPos");
-        if (viewPosLoc != -1) {
-            glUniform3fv(viewPosLoc, 1, glm::value_ptr(cameraPos));
-        }
-        
-        GLint ambientLightLoc = glGetUniformLocation(activeShader->ID, "ambientLight");
-        if (ambientLightLoc != -1) {
-            glUniform1f(ambientLightLoc, ambientLight);
+        if (drawChunk) {
+            // About the cube's size, centered on its middle
+            model = glm::scale(model, glm::vec3(1.25f / terrain.height()));
+            model = glm::translate(model, glm::vec3(-0.5f * CHUNK_WIDTH, -0.5f * terrain.height(), -0.5f * CHUNK_WIDTH));
         }
         
         // Make sure we have a valid ore to render
         int oreIndex = currentOreIndex % ores.size();
         OreProperties& currentOre = ores[oreIndex];
         
-        // Set ore color and glow strength if the shader supports these uniforms
-        GLint oreColorLoc = glGetUniformLocation(activeShader->ID, "oreColor");
-        if (oreColorLoc != -1) {
-            glUniform3fv(oreColorLoc, 1, glm::value_ptr(currentOre.color));
-        }
+        // One upload per block per frame; every program reading the blocks shares it
+        FrameConstants frameConstants;
+        frameConstants.model = model;
+        frameConstants.view = view;
+        frameConstants.projection = projection;
+        frameConstants.viewPos = cameraPos;
+        frameConstants.ambientLight = ambientLight;
+        frameConstants.bloomThreshold = bloomThreshold;
+        frameBlock->update(frameConstants);
         
-        GLint glowStrengthLoc = glGetUniformLocation(activeShader->ID, "glowStrength");
-        if (glowStrengthLoc != -1) {
-            glUniform1f(glowStrengthLoc, currentOre.glowStrength);
-        }
+        MaterialConstants materialConstants;
+        materialConstants.oreColor = currentOre.color;
+        materialConstants.glowStrength = currentOre.glowStrength;
+        materialBlock->update(materialConstants);
         
-        // Set bloom threshold for the shader (if it supports it)
-        GLint bloomThresholdLoc = glGetUniformLocation(activeShader->ID, "bloomThreshold");
-        if (bloomThresholdLoc != -1) {
-            glUniform1f(bloomThresholdLoc, bloomThreshold);
-        }
+        // Declare the frame: scene into the HDR targets and the HUD into its
+        // layer, then bloom and one composite of all of it onto the
+        // backbuffer. Unchanged inputs reuse
+        // last frame's bloom, and a static scene its scene targets too, once
+        // auto-exposure has settled (the bright output thresholds by it).
+        SceneView drawnView = drawField ? SceneView::OreField : drawChunk ? SceneView::Chunk : SceneView::Cube;
+        std::size_t sceneContent = drawField ? oreField->instanceCount() : drawChunk ? chunkMesh->triangleCount() : 0;
+        bool drawScene = postProcessor->beginFrame(hashScene(model, oreIndex, static_cast<int>(drawnView), sceneContent,
+                                                             ambientLight, bloomThreshold, glowingReady));
+        frameGraph->reset();
+        PostProcessor::SceneTargets scene = postProcessor->importSceneTargets(*frameGraph);
         
-        // Bind textures if the shader supports them and we have valid textures
-        GLint diffuseTexLoc = glGetUniformLocation(activeShader->ID, "diffuseTexture");
-        GLint emissiveTexLoc = glGetUniformLocation(activeShader->ID, "emissiveTexture");
+        if (drawScene) {
+            // Last frame's exposure: this frame's is metered from this scene
+            GLuint exposureTexture = postProcessor->getExposureTexture();
+            frameGraph->addPass("scene", [&, exposureTexture](const FrameGraph::Context&) {
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                // The bright buffer feeds bloom unthresholded: the background
+                // (and the fallback shader, which doesn't write it) must be black
+                const GLfloat black[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+                glClearBufferfv(GL_COLOR, 1, black);
+                
+                if (drawField) {
+                    fieldShader->use();
+                    glActiveTexture(GL_TEXTURE2);
+                    glBindTexture(GL_TEXTURE_2D, exposureTexture);
+                    oreField->draw();
+                    return;
+                }
+                if (drawChunk) {
+                    chunkShader->use();
+                    glActiveTexture(GL_TEXTURE2);
+                    glBindTexture(GL_TEXTURE_2D, exposureTexture);
+                    oreField->bindMaterials();
+                    chunkMesh->draw();
+                    return;
+                }
+                activeShader->use();
+            
+                // Bind textures if the shader samples them and we have valid textures
+                if (glowingReady && currentOre.diffuseMap != 0) {
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, currentOre.diffuseMap);
+                }
         
-        if (diffuseTexLoc != -1 && currentOre.diffuseMap != 0) {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, currentOre.diffuseMap);
-            glUniform1i(diffuseTexLoc, 0);
-        }
+                if (glowingReady && currentOre.emissiveMap != 0) {
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, currentOre.emissiveMap);
+                }
+                glActiveTexture(GL_TEXTURE2);
+                glBindTexture(GL_TEXTURE_2D, exposureTexture);
         
-        if (emissiveTexLoc != -1 && currentOre.emissiveMap != 0) {
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, currentOre.emissiveMap);
-            glUniform1i(emissiveTexLoc, 1);
+                // Draw cube
+                glBindVertexArray(VAO);
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }).write(scene.color).write(scene.bright).write(scene.depth).depthTest();
         }
         
-        // Draw cube
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        
-        // End rendering to framebuffer
-        postProcessor->endRender();
-        
-        // Apply bloom effect and render to screen
-        postProcessor->applyBloom(bloomThreshold, bloomIntensity, 10);
-        
-        // Render text indicators on screen if we have a text renderer
+        // Render text indicators into the HUD layer if we have a text renderer;
+        // the composite draws it over the frame
+        FrameResource hud = NO_FRAME_RESOURCE;
         if (textRenderer) {
-            // Create a vector of name-value pairs for the controls
-            std::vector<std::pair<std::string, float>> values = {
-                {"Ore Type", static_cast<float>(oreIndex)},
-                {"Ambient Light", ambientLight},
-                {"Bloom Intensity", bloomIntensity},
-                {"Bloom Threshold", bloomThreshold}
-            };
+            hud = postProcessor->createHudLayer(*frameGraph);
+            frameGraph->addPass("hud", [&](const FrameGraph::Context&) {
+                glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                
+                // Create a vector of name-value pairs for the controls
+                std::vector<std::pair<std::string, float>> values = {
+                    {"Ore Type", static_cast<float>(oreIndex)},
+                    {"Ambient Light", ambientLight},
+                    {"Bloom Intensity", bloomIntensity},
+                    {"Bloom Threshold", bloomThreshold}
+                };
             
-            // Render value bars
-            textRenderer->renderValueDisplays(values, 20.0f, SCR_HEIGHT - 100.0f, 30.0f);
+                // Render value bars
+                textRenderer->renderValueDisplays(values, 20.0f, SCR_HEIGHT - 100.0f, 30.0f);
             
-            // Render direction indicators for changing values
-            float indicatorX = 230.0f;
+                // Render direction indicators for changing values
+                float indicatorX = 230.0f;
             
-            // Ambient light change indicator
-            if (ambientLightIndicator.timeLeft > 0.0f) {
-                textRenderer->renderDirectionIndicator(
-                    indicatorX, SCR_HEIGHT - 130.0f, 
-                    ambientLightIndicator.increasing, 
-                    true, 
-                    glm::vec4(0.2f, 0.6f, 1.0f, 1.0f)
-                );
-            }
+                // Ambient light change indicator
+                if (ambientLightIndicator.timeLeft > 0.0f) {
+                    textRenderer->renderDirectionIndicator(
+                        indicatorX, SCR_HEIGHT - 130.0f, 
+                        ambientLightIndicator.increasing, 
+                        true, 
+                        glm::vec4(0.2f, 0.6f, 1.0f, 1.0f)
+                    );
+                }
             
-            // Bloom intensity change indicator
-            if (bloomIntensityIndicator.timeLeft > 0.0f) {
-                textRenderer->renderDirectionIndicator(
-                    indicatorX, SCR_HEIGHT - 160.0f, 
-                    bloomIntensityIndicator.increasing, 
-                    true, 
-                    glm::vec4(1.0f, 0.6f, 0.2f, 1.0f)
-                );
-            }
+                // Bloom intensity change indicator
+                if (bloomIntensityIndicator.timeLeft > 0.0f) {
+                    textRenderer->renderDirectionIndicator(
+                        indicatorX, SCR_HEIGHT - 160.0f, 
+                        bloomIntensityIndicator.increasing, 
+                        true, 
+                        glm::vec4(1.0f, 0.6f, 0.2f, 1.0f)
+                    );
+                }
             
-            // Bloom threshold change indicator
-            if (bloomThresholdIndicator.timeLeft > 0.0f) {
-                textRenderer->renderDirectionIndicator(
-                    indicatorX, SCR_HEIGHT - 190.0f, 
-                    bloomThresholdIndicator.increasing, 
-                    true, 
-                    glm::vec4(0.2f, 1.0f, 0.6f, 1.0f)
-                );
-            }
+                // Bloom threshold change indicator
+                if (bloomThresholdIndicator.timeLeft > 0.0f) {
+                    textRenderer->renderDirectionIndicator(
+                        indicatorX, SCR_HEIGHT - 190.0f, 
+                        bloomThresholdIndicator.increasing, 
+                        true, 
+                        glm::vec4(0.2f, 1.0f, 0.6f, 1.0f)
+                    );
+                }
             
-            // Render control help indicators
-            textRenderer->renderQuad(20.0f, 50.0f, 200.0f, 120.0f, glm::vec4(0.1f, 0.1f, 0.1f, 0.7f));
+                // Render control help indicators
+                textRenderer->renderQuad(20.0f, 50.0f, 200.0f, 120.0f, glm::vec4(0.1f, 0.1f, 0.1f, 0.7f));
             
-            // Render labeled bars for controls
-            textRenderer->renderValueIndicator(30.0f, 140.0f, 180.0f, 20.0f, ambientLight, 0.0f, 1.0f, 
-                                              glm::vec4(0.2f, 0.6f, 1.0f, 1.0f));
-            textRenderer->renderValueIndicator(30.0f, 110.0f, 180.0f, 20.0f, bloomIntensity, 0.0f, 5.0f, 
-                                              glm::vec4(1.0f, 0.6f, 0.2f, 1.0f));
-            textRenderer->renderValueIndicator(30.0f, 80.0f, 180.0f, 20.0f, bloomThreshold, 0.0f, 1.0f, 
-                                              glm::vec4(0.2f, 1.0f, 0.6f, 1.0f));
+                // Render labeled bars for controls
+                textRenderer->renderValueIndicator(30.0f, 140.0f, 180.0f, 20.0f, ambientLight, 0.0f, 1.0f, 
+                                                  glm::vec4(0.2f, 0.6f, 1.0f, 1.0f));
+                textRenderer->renderValueIndicator(30.0f, 110.0f, 180.0f, 20.0f, bloomIntensity, 0.0f, 5.0f, 
+                                                  glm::vec4(1.0f, 0.6f, 0.2f, 1.0f));
+                textRenderer->renderValueIndicator(30.0f, 80.0f, 180.0f, 20.0f, bloomThreshold, 0.0f, 1.0f, 
+                                                  glm::vec4(0.2f, 1.0f, 0.6f, 1.0f));
+            }).write(hud).blend(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        
+        // A different ore glows differently; don't smear the old one into it
+        if (oreIndex != prev_oreIndex) {
+            postProcessor->resetBloomHistory();
+        }
+        postProcessor->addBloomPasses(*frameGraph, scene, bloomThreshold, bloomIntensity,
+                                      bloomGovernor->radius(bloomRadius), hud);
+        
+        frameGraph->compile();
+        if (dumpFrameGraph) {
+            frameGraph->dump(std::cout);
+            dumpFrameGraph = false;
+        }
+        frameGraph->execute(passTimer);
+        bloomGovernor->update(*passTimer);
+        
+        // Step through the instance counts once everything is built, timing
+        // frames and the scene pass after each switch has settled
+        if (!instanceRuns.empty() && fieldShader->hasFailed()) {
+            std::cerr << "Ore field shaders failed to build; nothing to benchmark" << std::endl;
+            instanceRuns.clear();
+            glfwSetWindowShouldClose(window, true);
+        }
+        if (!instanceRuns.empty() && startupReported && drawField) {
+            InstanceMeasurement& run = instanceRuns[instanceIndex];
+            if (instanceWarmup < 0) {
+                oreField->setInstances(OreFieldRenderer::generateField(run.blocks, fieldOreTypes, FIELD_SPACING));
+                instanceWarmup = 8;
+            } else if (instanceWarmup > 0) {
+                instanceWarmup--;
+                lastPassFrame = passTimer->frameCount();
+            } else {
+                run.frameMilliseconds += deltaTime * 1000.0;
+                run.frames++;
+                if (passTimer->frameCount() != lastPassFrame) {
+                    lastPassFrame = passTimer->frameCount();
+                    run.sceneMilliseconds += passTimer->milliseconds("scene");
+                    run.sceneSamples++;
+                }
+                if (run.frames == 120) {
+                    instanceWarmup = -1;
+                    if (++instanceIndex == instanceRuns.size()) {
+                        reportInstanceMeasurements(instanceRuns);
+                        instanceRuns.clear();
+                        glfwSetWindowShouldClose(window, true);
+                    }
+                }
+            }
         }
         
         // Swap buffers and poll events
         glfwSwapBuffers(window);
         glfwPollEvents();
         
+        // Steady-state frames (after every build has finished) should never hit
+        // the driver for a uniform location
+        unsigned int uniformLookups = Shader::takeDriverLookups();
+        if (uniformLookups > 0 && startupReported) {
+            std::cerr << "Warning: " << uniformLookups << " driver uniform lookups in frame " << frameCount << std::endl;
+        }
+        
+        // Report program build cost once everything is in, so cold and warm starts can be compared
+        if (!startupReported && (glowingReady || !glowingShader || glowingShader->hasFailed()) && postProcessor->isReady()) {
+            Shader::BuildStats buildStats = Shader::buildStats();
+            std::cout << (buildStats.cacheHits == buildStats.programs ? "Warm" : "Cold") << " start: "
+                      << buildStats.programs << " shader programs built in " << std::fixed << std::setprecision(2)
+                      << buildStats.milliseconds << " ms (" << buildStats.cacheHits << " from binary cache), "
+                      << frameCount << " frames rendered with the fallback shaders" << std::endl;
+            startupReported = true;
+        }
+        
+        // Measure each target format configuration once everything is built.
+        // Queries from the previous configuration drain during the warmup.
+        GpuTimer& bloomTimer = postProcessor->getBloomTimer();
+        if (!measurements.empty() && startupReported) {
+            if (measureWarmup < 0 || (measureWarmup == 0 && bloomTimer.sampleCount() >= 120)) {
+                if (measureWarmup == 0) {
+                    measurements[measureIndex].milliseconds = bloomTimer.averageMilliseconds();
+                    measurements[measureIndex].bytes = frameGraph->bytesMoved();
+                    measureIndex++;
+                }
+                if (measureIndex == measurements.size()) {
+                    reportFormatMeasurements(measurements);
+                    measurements.clear();
+                    glfwSetWindowShouldClose(window, true);
+                } else {
+                    const FormatMeasurement& next = measurements[measureIndex];
+                    postProcessor->setTargetFormats(next.formats);
+                    postProcessor->resize(next.width, next.height);
+                    measureWarmup = 8;
+                }
+            } else if (measureWarmup > 0 && --measureWarmup == 0) {
+                bloomTimer.reset();
+            }
+        }
+        
+        // Average bloom GPU time every few seconds, for A/B timing of the modes
+        if (measurements.empty() && bloomTimer.sampleCount() >= 240) {
+            const RenderTargetPool& targets = postProcessor->getRenderTargets();
+            std::cout << "Bloom (" << bloomModeName(postProcessor->getBloomMode()) << "): " << std::fixed << std::setprecision(3) << bloomTimer.averageMilliseconds()
+                      << " ms GPU, " << targets.targetCount() << " render targets ("
+                      << std::setprecision(1) << targets.allocatedBytes() / (1024.0 * 1024.0) << " MB), governor level "
+                      << bloomGovernor->getLevel() << (bloomGovernor->isEnabled() ? "" : " (off)") << std::endl;
+            bloomTimer.reset();
+        }
+        
+        frameCount++;
+        
         // Only print when values change
         if (prev_ambientLight != ambientLight || prev_bloomIntensity != bloomIntensity || 
             prev_bloomThreshold != bloomThreshold || prev_oreIndex != oreIndex) {
@@ -750,10 +1438,24 @@ int main() {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     
-    delete activeShader;
+    delete shaderWatcher;
+    delete frameBlock;
+    delete materialBlock;
+    delete chunkMesh;
+    delete oreField;
+    delete glowingShader;
+    delete fieldShader;
+    delete chunkShader;
+    delete fallbackShader;
+    delete bloomGovernor;
+    delete passTimer;
+    delete frameGraph;
     delete postProcessor;
+    Shader::releaseVariants();
     if (textRenderer) delete textRenderer;
     
+    ShaderCompileWorker::stop();
+    
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
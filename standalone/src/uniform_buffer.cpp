@@ -0,0 +1,80 @@
+#include "uniform_buffer.h"
+
+#include <cstring>
+#include <iostream>
+
+bool uniformBlockBinding(const std::string& blockName, GLuint& binding) {
+    static const struct {
+        const char* name;
+        GLuint binding;
+    } blocks[] = {
+        {"FrameConstants", FRAME_BLOCK_BINDING},
+        {"MaterialConstants", MATERIAL_BLOCK_BINDING},
+        {"BlurKernel", BLUR_KERNEL_BLOCK_BINDING},
+        {"OreMaterials", ORE_MATERIAL_BLOCK_BINDING}
+    };
+
+    for (const auto& block : blocks) {
+        if (blockName == block.name) {
+            binding = block.binding;
+            return true;
+        }
+    }
+    return false;
+}
+
+UniformRingBuffer::UniformRingBuffer(GLuint binding, std::size_t size, unsigned int frames)
+    : binding(binding), size(size), frames(frames < MAX_FRAMES ? frames : MAX_FRAMES), current(0) {
+    // Every slot has to start on an offset the driver accepts for glBindBufferRange
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride = (static_cast<GLsizeiptr>(size) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, stride * this->frames, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    for (unsigned int i = 0; i < MAX_FRAMES; i++) {
+        fences[i] = 0;
+    }
+}
+
+UniformRingBuffer::~UniformRingBuffer() {
+    for (unsigned int i = 0; i < MAX_FRAMES; i++) {
+        if (fences[i]) glDeleteSync(fences[i]);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void UniformRingBuffer::update(const void* data) {
+    // Everything drawn since the last update read the current slot
+    if (fences[current]) glDeleteSync(fences[current]);
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    current = (current + 1) % frames;
+
+    // Only blocks if the GPU is a full ring behind
+    if (fences[current]) {
+        GLenum result = glClientWaitSync(fences[current], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            glClientWaitSync(fences[current], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        glDeleteSync(fences[current]);
+        fences[current] = 0;
+    }
+
+    GLintptr offset = stride * current;
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    void* target = glMapBufferRange(GL_UNIFORM_BUFFER, offset, stride,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (target) {
+        std::memcpy(target, data, size);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    } else {
+        std::cerr << "Failed to map uniform buffer for binding " << binding << std::endl;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, stride);
+}
@@ -0,0 +1,100 @@
+#include "uniform_table.h"
+
+#include <cstring>
+
+unsigned int UniformTable::build(GLuint program) {
+    clear();
+
+    GLint activeUniforms = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &activeUniforms);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    // Keep the load factor at or below 50% so probe chains stay short
+    std::size_t capacity = 8;
+    while (capacity < static_cast<std::size_t>(activeUniforms) * 2) {
+        capacity *= 2;
+    }
+    entries.assign(capacity, Entry{0, 0, {-1, GL_NONE, 0}});
+
+    unsigned int lookups = 0;
+    std::vector<char> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+    for (GLint i = 0; i < activeUniforms; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(program, i, static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+
+        // Uniforms inside uniform blocks have no location and are set through buffers
+        GLint location = glGetUniformLocation(program, nameBuffer.data());
+        lookups++;
+        if (location == -1) {
+            continue;
+        }
+
+        // Store arrays under their base name so "weights" and "weights[0]" both work
+        std::string name(nameBuffer.data(), length);
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            name.resize(name.size() - 3);
+        }
+
+        insert(name, UniformInfo{location, type, size});
+    }
+
+    return lookups;
+}
+
+const UniformInfo* UniformTable::find(const std::string& name) const {
+    if (entries.empty()) {
+        return nullptr;
+    }
+
+    std::string key = name;
+    if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) {
+        key.resize(key.size() - 3);
+    }
+
+    uint32_t hash = hashName(key.c_str(), key.size());
+    std::size_t mask = entries.size() - 1;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Entry& entry = entries[i];
+        if (entry.hash == 0) {
+            return nullptr;
+        }
+        if (entry.hash == hash && std::strcmp(names.c_str() + entry.nameOffset, key.c_str()) == 0) {
+            return &entry.info;
+        }
+    }
+}
+
+void UniformTable::clear() {
+    entries.clear();
+    names.clear();
+    count = 0;
+}
+
+uint32_t UniformTable::hashName(const char* name, std::size_t length) {
+    // FNV-1a, with 0 reserved for empty slots
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+void UniformTable::insert(const std::string& name, const UniformInfo& info) {
+    uint32_t hash = hashName(name.c_str(), name.size());
+    std::size_t mask = entries.size() - 1;
+    std::size_t i = hash & mask;
+    while (entries[i].hash != 0) {
+        i = (i + 1) & mask;
+    }
+
+    entries[i].hash = hash;
+    entries[i].nameOffset = static_cast<uint32_t>(names.size());
+    entries[i].info = info;
+    names.append(name);
+    names.push_back('\0');
+    count++;
+}